@@ -0,0 +1,407 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2023 yg331.
+//------------------------------------------------------------------------
+
+#include "lunchboxaudiofile.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#endif
+
+using namespace Steinberg;
+
+namespace yg331 {
+
+	static const uint16 kWaveFormatPCM = 0x0001;
+	static const uint16 kWaveFormatFloat = 0x0003;
+	static const uint16 kWaveFormatExtensible = 0xFFFE;
+
+	static uint16 readLE16(const unsigned char* p) { return (uint16)(p[0] | (p[1] << 8)); }
+	static uint32 readLE32(const unsigned char* p) { return (uint32)p[0] | ((uint32)p[1] << 8) | ((uint32)p[2] << 16) | ((uint32)p[3] << 24); }
+	static void writeLE16(unsigned char* p, uint16 v) { p[0] = (unsigned char)v; p[1] = (unsigned char)(v >> 8); }
+	static void writeLE32(unsigned char* p, uint32 v) { for (int i = 0; i < 4; i++) p[i] = (unsigned char)(v >> (8 * i)); }
+
+	//------------------------------------------------------------------------
+	bool parseSampleFormat(const char* name, SampleFormat& format)
+	{
+		if (strcmp(name, "s16") == 0) format = SampleFormat::kInt16;
+		else if (strcmp(name, "s24") == 0) format = SampleFormat::kInt24;
+		else if (strcmp(name, "s32") == 0) format = SampleFormat::kInt32;
+		else if (strcmp(name, "f32") == 0) format = SampleFormat::kFloat32;
+		else if (strcmp(name, "f64") == 0) format = SampleFormat::kFloat64;
+		else return false;
+		return true;
+	}
+
+	//------------------------------------------------------------------------
+	int32 bytesPerSample(SampleFormat format)
+	{
+		switch (format) {
+		case SampleFormat::kInt16:   return 2;
+		case SampleFormat::kInt24:   return 3;
+		case SampleFormat::kInt32:   return 4;
+		case SampleFormat::kFloat32: return 4;
+		case SampleFormat::kFloat64: return 8;
+		}
+		return 0;
+	}
+
+	//------------------------------------------------------------------------
+	static double decodeSample(const unsigned char* p, SampleFormat format)
+	{
+		switch (format) {
+		case SampleFormat::kInt16:
+			return (int16)readLE16(p) / 32768.0;
+		case SampleFormat::kInt24: {
+			int32 v = (int32)((uint32)p[0] << 8 | (uint32)p[1] << 16 | (uint32)p[2] << 24) >> 8;
+			return v / 8388608.0;
+		}
+		case SampleFormat::kInt32:
+			return (int32)readLE32(p) / 2147483648.0;
+		case SampleFormat::kFloat32: {
+			uint32 bits = readLE32(p);
+			float v; memcpy(&v, &bits, 4);
+			return v;
+		}
+		case SampleFormat::kFloat64: {
+			uint64 bits = (uint64)readLE32(p) | ((uint64)readLE32(p + 4) << 32);
+			double v; memcpy(&v, &bits, 8);
+			return v;
+		}
+		}
+		return 0.0;
+	}
+
+	//------------------------------------------------------------------------
+	static int32 quantize(double value, double scale, double maxValue)
+	{
+		double v = floor(value * scale + 0.5);
+		if (v > maxValue) v = maxValue;
+		if (v < -maxValue - 1.0) v = -maxValue - 1.0;
+		return (int32)v;
+	}
+
+	static void encodeSample(unsigned char* p, double value, SampleFormat format)
+	{
+		switch (format) {
+		case SampleFormat::kInt16:
+			writeLE16(p, (uint16)quantize(value, 32768.0, 32767.0));
+			break;
+		case SampleFormat::kInt24: {
+			uint32 v = (uint32)quantize(value, 8388608.0, 8388607.0);
+			p[0] = (unsigned char)v; p[1] = (unsigned char)(v >> 8); p[2] = (unsigned char)(v >> 16);
+			break;
+		}
+		case SampleFormat::kInt32:
+			writeLE32(p, (uint32)quantize(value, 2147483648.0, 2147483647.0));
+			break;
+		case SampleFormat::kFloat32: {
+			float v = (float)value; uint32 bits;
+			memcpy(&bits, &v, 4);
+			writeLE32(p, bits);
+			break;
+		}
+		case SampleFormat::kFloat64: {
+			uint64 bits;
+			memcpy(&bits, &value, 8);
+			writeLE32(p, (uint32)bits);
+			writeLE32(p + 4, (uint32)(bits >> 32));
+			break;
+		}
+		}
+	}
+
+	//------------------------------------------------------------------------
+	// AudioFileReader
+	//------------------------------------------------------------------------
+	bool AudioFileReader::openWav(const char* path, std::string& error)
+	{
+		close();
+		file = fopen(path, "rb");
+		if (!file) {
+			error = std::string("cannot open ") + path;
+			return false;
+		}
+
+		unsigned char header[12];
+		if (fread(header, 1, 12, file) != 12 || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+			error = std::string(path) + " is not a RIFF/WAVE file";
+			close();
+			return false;
+		}
+
+		bool haveFormat = false;
+		while (true)
+		{
+			unsigned char chunk[8];
+			if (fread(chunk, 1, 8, file) != 8) {
+				error = std::string(path) + " has no data chunk";
+				close();
+				return false;
+			}
+			uint32 chunkSize = readLE32(chunk + 4);
+
+			if (memcmp(chunk, "fmt ", 4) == 0)
+			{
+				unsigned char fmt[40] = { 0, };
+				uint32 toRead = chunkSize < sizeof(fmt) ? chunkSize : (uint32)sizeof(fmt);
+				if (chunkSize < 16 || fread(fmt, 1, toRead, file) != toRead) {
+					error = std::string(path) + " has a broken fmt chunk";
+					close();
+					return false;
+				}
+				fseek(file, (long)(chunkSize - toRead + (chunkSize & 1)), SEEK_CUR);
+
+				uint16 formatTag = readLE16(fmt);
+				uint16 bits = readLE16(fmt + 14);
+				if (formatTag == kWaveFormatExtensible && chunkSize >= 26)
+					formatTag = readLE16(fmt + 24); // first two bytes of the SubFormat GUID
+
+				info.numChannels = readLE16(fmt + 2);
+				info.sampleRate = (double)readLE32(fmt + 4);
+
+				if (formatTag == kWaveFormatPCM && bits == 16) info.format = SampleFormat::kInt16;
+				else if (formatTag == kWaveFormatPCM && bits == 24) info.format = SampleFormat::kInt24;
+				else if (formatTag == kWaveFormatPCM && bits == 32) info.format = SampleFormat::kInt32;
+				else if (formatTag == kWaveFormatFloat && bits == 32) info.format = SampleFormat::kFloat32;
+				else if (formatTag == kWaveFormatFloat && bits == 64) info.format = SampleFormat::kFloat64;
+				else {
+					error = std::string(path) + " uses an unsupported sample format";
+					close();
+					return false;
+				}
+				haveFormat = true;
+			}
+			else if (memcmp(chunk, "data", 4) == 0)
+			{
+				if (!haveFormat || info.numChannels <= 0) {
+					error = std::string(path) + " has data before fmt";
+					close();
+					return false;
+				}
+				// 0 and 0xFFFFFFFF are written by streaming recorders that never patched the header
+				if (chunkSize == 0 || chunkSize == 0xFFFFFFFF) info.numFrames = -1;
+				else info.numFrames = chunkSize / (bytesPerSample(info.format) * info.numChannels);
+				framesLeft = info.numFrames;
+				return true;
+			}
+			else
+			{
+				fseek(file, (long)(chunkSize + (chunkSize & 1)), SEEK_CUR);
+			}
+		}
+	}
+
+	//------------------------------------------------------------------------
+	bool AudioFileReader::openRaw(const char* path, const AudioFileInfo& rawInfo, std::string& error)
+	{
+		close();
+		file = fopen(path, "rb");
+		if (!file) {
+			error = std::string("cannot open ") + path;
+			return false;
+		}
+		info = rawInfo;
+		info.numFrames = -1;
+		framesLeft = -1;
+		return true;
+	}
+
+	//------------------------------------------------------------------------
+	void AudioFileReader::close()
+	{
+		if (file) fclose(file);
+		file = nullptr;
+	}
+
+	//------------------------------------------------------------------------
+	int32 AudioFileReader::read(double** channels, int32 numFrames)
+	{
+		if (!file) return 0;
+		if (framesLeft >= 0 && numFrames > framesLeft) numFrames = (int32)framesLeft;
+
+		int32 sampleBytes = bytesPerSample(info.format);
+		int32 frameBytes = sampleBytes * info.numChannels;
+		interleaved.resize((size_t)frameBytes * numFrames);
+
+		int32 framesRead = (int32)(fread(interleaved.data(), frameBytes, numFrames, file));
+		if (framesLeft >= 0) framesLeft -= framesRead;
+
+		const unsigned char* p = interleaved.data();
+		for (int32 n = 0; n < framesRead; n++)
+			for (int32 ch = 0; ch < info.numChannels; ch++, p += sampleBytes)
+				channels[ch][n] = decodeSample(p, info.format);
+
+		return framesRead;
+	}
+
+	//------------------------------------------------------------------------
+	// AudioFileWriter
+	//------------------------------------------------------------------------
+	bool AudioFileWriter::open(const char* path, const AudioFileInfo& fileInfo, bool rawFile, std::string& error)
+	{
+		close();
+		file = fopen(path, "wb");
+		if (!file) {
+			error = std::string("cannot create ") + path;
+			return false;
+		}
+		info = fileInfo;
+		raw = rawFile;
+		framesWritten = 0;
+		if (!raw && !writeHeader()) {
+			error = std::string("cannot write ") + path;
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	//------------------------------------------------------------------------
+	bool AudioFileWriter::writeHeader()
+	{
+		int32 sampleBytes = bytesPerSample(info.format);
+		uint64 dataBytes = (uint64)framesWritten * sampleBytes * info.numChannels;
+		if (dataBytes > 0xFFFFFFFFull - 36) dataBytes = 0xFFFFFFFFull - 36; // RIFF can not describe more
+
+		bool isFloat = info.format == SampleFormat::kFloat32 || info.format == SampleFormat::kFloat64;
+
+		unsigned char header[44];
+		memcpy(header, "RIFF", 4);
+		writeLE32(header + 4, (uint32)(36 + dataBytes));
+		memcpy(header + 8, "WAVE", 4);
+		memcpy(header + 12, "fmt ", 4);
+		writeLE32(header + 16, 16);
+		writeLE16(header + 20, isFloat ? kWaveFormatFloat : kWaveFormatPCM);
+		writeLE16(header + 22, (uint16)info.numChannels);
+		writeLE32(header + 24, (uint32)info.sampleRate);
+		writeLE32(header + 28, (uint32)info.sampleRate * sampleBytes * info.numChannels);
+		writeLE16(header + 32, (uint16)(sampleBytes * info.numChannels));
+		writeLE16(header + 34, (uint16)(sampleBytes * 8));
+		memcpy(header + 36, "data", 4);
+		writeLE32(header + 40, (uint32)dataBytes);
+
+		return fwrite(header, 1, 44, file) == 44;
+	}
+
+	//------------------------------------------------------------------------
+	bool AudioFileWriter::write(double** channels, int32 numFrames)
+	{
+		if (!file) return false;
+
+		int32 sampleBytes = bytesPerSample(info.format);
+		int32 frameBytes = sampleBytes * info.numChannels;
+		interleaved.resize((size_t)frameBytes * numFrames);
+
+		unsigned char* p = interleaved.data();
+		for (int32 n = 0; n < numFrames; n++)
+			for (int32 ch = 0; ch < info.numChannels; ch++, p += sampleBytes)
+				encodeSample(p, channels[ch][n], info.format);
+
+		framesWritten += numFrames;
+		return fwrite(interleaved.data(), frameBytes, numFrames, file) == (size_t)numFrames;
+	}
+
+	//------------------------------------------------------------------------
+	bool AudioFileWriter::close()
+	{
+		if (!file) return true;
+
+		bool ok = true;
+		if (!raw) {
+			ok = fseek(file, 0, SEEK_SET) == 0 && writeHeader();
+		}
+		ok = (fclose(file) == 0) && ok;
+		file = nullptr;
+		return ok;
+	}
+
+	//------------------------------------------------------------------------
+	bool TempSampleFile::open(int32 channels, std::string& error)
+	{
+		close();
+		file = tmpfile();
+		if (!file) {
+			error = "cannot create a temporary file";
+			return false;
+		}
+		numChannels = channels;
+		framesWritten = 0;
+		return true;
+	}
+
+	//------------------------------------------------------------------------
+	bool TempSampleFile::write(double** channels, int32 numFrames)
+	{
+		if (!file || view) return false;
+
+		interleaved.resize((size_t)numChannels * numFrames);
+		double* p = interleaved.data();
+		for (int32 n = 0; n < numFrames; n++)
+			for (int32 ch = 0; ch < numChannels; ch++)
+				*p++ = channels[ch][n];
+
+		framesWritten += numFrames;
+		return fwrite(interleaved.data(), sizeof(double) * numChannels, numFrames, file) == (size_t)numFrames;
+	}
+
+	//------------------------------------------------------------------------
+	const double* TempSampleFile::map(std::string& error)
+	{
+		if (view) return (const double*)view;
+		if (!file || framesWritten == 0) return nullptr;
+
+		uint64 bytes = (uint64)framesWritten * numChannels * sizeof(double);
+		if (fflush(file) != 0 || bytes > (uint64)SIZE_MAX) {
+			error = "cannot map the temporary file";
+			return nullptr;
+		}
+#if defined(_WIN32)
+		HANDLE handle = (HANDLE)_get_osfhandle(_fileno(file));
+		mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, (DWORD)(bytes >> 32), (DWORD)bytes, nullptr);
+		if (mapping) view = MapViewOfFile((HANDLE)mapping, FILE_MAP_READ, 0, 0, (SIZE_T)bytes);
+		if (!view) {
+			error = "cannot map the temporary file";
+			return nullptr;
+		}
+#else
+		void* p = mmap(nullptr, (size_t)bytes, PROT_READ, MAP_SHARED, fileno(file), 0);
+		if (p == MAP_FAILED) {
+			error = "cannot map the temporary file";
+			return nullptr;
+		}
+		madvise(p, (size_t)bytes, MADV_SEQUENTIAL);	// read once, front to back
+		view = p;
+#endif
+		viewBytes = (size_t)bytes;
+		return (const double*)view;
+	}
+
+	//------------------------------------------------------------------------
+	void TempSampleFile::close()
+	{
+#if defined(_WIN32)
+		if (view) UnmapViewOfFile(view);
+		if (mapping) CloseHandle((HANDLE)mapping);
+		mapping = nullptr;
+#else
+		if (view) munmap((void*)view, viewBytes);
+#endif
+		view = nullptr;
+		viewBytes = 0;
+		if (file) fclose(file);
+		file = nullptr;
+	}
+
+	//------------------------------------------------------------------------
+} // namespace yg331
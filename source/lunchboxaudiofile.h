@@ -0,0 +1,117 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2023 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "pluginterfaces/base/ftypes.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace yg331 {
+
+	//------------------------------------------------------------------------
+	//  Streaming WAV / raw PCM file access for the offline renderer
+	//------------------------------------------------------------------------
+	enum class SampleFormat
+	{
+		kInt16,
+		kInt24,
+		kInt32,
+		kFloat32,
+		kFloat64
+	};
+
+	/** Parses "s16", "s24", "s32", "f32" or "f64". */
+	bool parseSampleFormat(const char* name, SampleFormat& format);
+	Steinberg::int32 bytesPerSample(SampleFormat format);
+
+	struct AudioFileInfo
+	{
+		SampleFormat format = SampleFormat::kFloat32;
+		Steinberg::int32 numChannels = 2;
+		double sampleRate = 48000.0;
+		Steinberg::int64 numFrames = -1; // -1 : unknown (raw stream)
+	};
+
+	class AudioFileReader
+	{
+	public:
+		AudioFileReader() = default;
+		~AudioFileReader() { close(); }
+
+		/** Opens a RIFF/WAVE file. */
+		bool openWav(const char* path, std::string& error);
+		/** Opens headerless interleaved PCM, described by info. */
+		bool openRaw(const char* path, const AudioFileInfo& info, std::string& error);
+		void close();
+
+		const AudioFileInfo& getInfo() const { return info; }
+
+		/** Reads up to numFrames frames, deinterleaved into channels. Returns frames read. */
+		Steinberg::int32 read(double** channels, Steinberg::int32 numFrames);
+
+	private:
+		FILE* file = nullptr;
+		AudioFileInfo info;
+		Steinberg::int64 framesLeft = -1;
+		std::vector<unsigned char> interleaved;
+	};
+
+	class AudioFileWriter
+	{
+	public:
+		AudioFileWriter() = default;
+		~AudioFileWriter() { close(); }
+
+		/** raw == true writes headerless interleaved PCM, otherwise RIFF/WAVE. */
+		bool open(const char* path, const AudioFileInfo& info, bool raw, std::string& error);
+		bool write(double** channels, Steinberg::int32 numFrames);
+		/** Patches the WAVE header sizes and closes the file. */
+		bool close();
+
+	private:
+		bool writeHeader();
+
+		FILE* file = nullptr;
+		AudioFileInfo info;
+		bool raw = false;
+		Steinberg::int64 framesWritten = 0;
+		std::vector<unsigned char> interleaved;
+	};
+
+	/** The intermediate of a two-pass render: interleaved doubles appended to
+	    an anonymous temporary file, then mapped back into memory in one
+	    piece for the second pass. The file is gone once closed. */
+	class TempSampleFile
+	{
+	public:
+		TempSampleFile() = default;
+		~TempSampleFile() { close(); }
+
+		bool open(Steinberg::int32 numChannels, std::string& error);
+		/** Same as AudioFileWriter::write, losslessly */
+		bool write(double** channels, Steinberg::int32 numFrames);
+		/** Everything written so far, getNumFrames() frames of interleaved
+		    doubles; nullptr if nothing was written or it failed */
+		const double* map(std::string& error);
+		void close();
+
+		Steinberg::int64 getNumFrames() const { return framesWritten; }
+
+	private:
+		FILE* file = nullptr;
+		Steinberg::int32 numChannels = 0;
+		Steinberg::int64 framesWritten = 0;
+		std::vector<double> interleaved;
+		const void* view = nullptr;
+		size_t viewBytes = 0;
+#if defined(_WIN32)
+		void* mapping = nullptr;	// HANDLE of the file mapping
+#endif
+	};
+
+	//------------------------------------------------------------------------
+} // namespace yg331
@@ -0,0 +1,160 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2023 yg331.
+//------------------------------------------------------------------------
+
+#include "lunchboxbank.h"
+#include "lunchboxdenormals.h"
+
+#include <algorithm>
+
+namespace yg331 {
+
+	//------------------------------------------------------------------------
+	// LunchboxBank Implementation
+	//------------------------------------------------------------------------
+	LunchboxBank::LunchboxBank(int32 numStrips)
+	: numStrips(numStrips > 0 ? numStrips : 1)
+	{
+		numGroups = (2 * this->numStrips + BankLanes::kLanes - 1) / BankLanes::kLanes;
+		settings = new lunchboxProcessor;
+		reset();
+	}
+
+	//------------------------------------------------------------------------
+	LunchboxBank::~LunchboxBank()
+	{
+		settings->release();
+	}
+
+	//------------------------------------------------------------------------
+	void LunchboxBank::setupProcessing(Vst::Sample64 newSampleRate, int32 newMaxSamplesPerBlock)
+	{
+		sampleRate = newSampleRate;
+		maxSamplesPerBlock = newMaxSamplesPerBlock > 0 ? newMaxSamplesPerBlock : 1;
+
+		Vst::ProcessSetup setup;
+		setup.processMode = Vst::kOffline;
+		setup.symbolicSampleSize = Vst::kSample64;
+		setup.maxSamplesPerBlock = maxSamplesPerBlock;
+		setup.sampleRate = sampleRate;
+		settings->setupProcessing(setup);
+
+		lanes.assign((size_t)maxSamplesPerBlock * BankLanes::kLanes, 0.0);
+		reset();
+	}
+
+	//------------------------------------------------------------------------
+	void LunchboxBank::setParameter(Vst::ParamID id, Vst::ParamValue value)
+	{
+		// the strips run at the host rate, Channel9 must not get oversampled coefficients,
+		// and each channel of a strip is compressed on its own
+		if (id == kParamOversampling || id == kParamDetect) return;
+		settings->setParameter(id, value);
+	}
+
+	//------------------------------------------------------------------------
+	tresult LunchboxBank::setState(IBStream* state)
+	{
+		tresult result = settings->setState(state);
+		settings->setParameter(kParamOversampling, 0.0);
+		settings->setParameter(kParamDetect, 0.0);
+		return result;
+	}
+
+	//------------------------------------------------------------------------
+	void LunchboxBank::reset()
+	{
+		channel9.assign(numGroups, Channel9State<BankLanes>());
+		eq.assign(numGroups, EQState<BankLanes>());
+		comp.assign(numGroups, CompState<BankLanes>());
+		settings->resetSmoothers();
+		settings->snapSmoothers = true;
+	}
+
+	//------------------------------------------------------------------------
+	template <typename SampleType>
+	void LunchboxBank::process(SampleType** channels, int32 sampleFrames)
+	{
+		if (sampleFrames <= 0 || maxSamplesPerBlock <= 0) return;
+
+		ScopedDenormals noDenormals;
+
+		// the lane buffer and the smoothers hold maxSamplesPerBlock frames,
+		// longer blocks go through in pieces of that
+		for (int32 done = 0; done < sampleFrames; done += maxSamplesPerBlock)
+			processChunk(channels, done, std::min(maxSamplesPerBlock, sampleFrames - done));
+	}
+
+	//------------------------------------------------------------------------
+	template <typename SampleType>
+	void LunchboxBank::processChunk(SampleType** channels, int32 offset, int32 sampleFrames)
+	{
+		const int32 K = BankLanes::kLanes;
+		const int32 numChannels = 2 * numStrips;
+
+		// the coefficients are the same for every strip, and only worked out
+		// again when the settings change
+		settings->updateCoeffs(sampleRate);
+		const Channel9Coeffs& channel9Coeffs = settings->channel9Coeffs;
+		const CompCoeffs& compCoeffs = settings->compCoeffs;
+		const EQCoeffs& eqCoeffs = settings->eqCoeffs;
+
+		const Vst::Sample64* drive = settings->smoothDrive.process(sampleFrames);
+		int32 stride = settings->smoothFocus.isSmoothing() ? lunchboxProcessor::kFocusUpdateStride : sampleFrames;
+		const Vst::Sample64* focus = settings->smoothFocus.process(sampleFrames);
+		settings->snapSmoothers = false;
+
+		Vst::Sample64 tmp = 1.0; // meter, not reported by the bank
+
+		for (int32 g = 0; g < numGroups; g++)
+		{
+			// gather: one frame of the K channels of this group per BankLanes,
+			// the lanes past the last strip run on silence
+			Vst::Sample64* frame = lanes.data();
+			for (int32 i = 0; i < K; i++)
+			{
+				int32 ch = g * K + i;
+				if (ch < numChannels)
+					for (int32 n = 0; n < sampleFrames; n++) frame[n * K + i] = channels[ch][offset + n];
+				else
+					for (int32 n = 0; n < sampleFrames; n++) frame[n * K + i] = 0.0;
+			}
+
+			Channel9State<BankLanes>& channel9State = channel9[g];
+			EQState<BankLanes>& eqState = eq[g];
+			CompState<BankLanes>& compState = comp[g];
+
+			for (int32 pos = 0; pos < sampleFrames; pos += stride)
+			{
+				int32 chunkFrames = (sampleFrames - pos < stride) ? sampleFrames - pos : stride;
+				settings->setPeakCoeffs(focus[pos]);
+
+				for (int32 n = pos; n < pos + chunkFrames; n++)
+				{
+					BankLanes inputSample = BankLanes::load(frame + n * K);
+
+					tickChannel9(channel9State, inputSample, channel9Coeffs, drive[n]);
+					tickEQ(eqState, inputSample, eqCoeffs);
+					if (compCoeffs.efficient) tickCompEfficient(compState, inputSample, compCoeffs, tmp);
+					else tickComp(compState, inputSample, compCoeffs, tmp);
+
+					inputSample.store(frame + n * K);
+				}
+			}
+
+			// scatter
+			for (int32 i = 0; i < K; i++)
+			{
+				int32 ch = g * K + i;
+				if (ch < numChannels)
+					for (int32 n = 0; n < sampleFrames; n++) channels[ch][offset + n] = (SampleType)frame[n * K + i];
+			}
+		}
+	}
+
+	//------------------------------------------------------------------------
+	template void LunchboxBank::process<Vst::Sample32>(Vst::Sample32**, int32);
+	template void LunchboxBank::process<Vst::Sample64>(Vst::Sample64**, int32);
+
+	//------------------------------------------------------------------------
+} // namespace yg331
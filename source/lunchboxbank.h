@@ -0,0 +1,91 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2023 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "lunchboxprocessor.h"
+
+#include <vector>
+
+namespace yg331 {
+
+	//------------------------------------------------------------------------
+	//  Lane type of the bank: the widest the build targets
+	//------------------------------------------------------------------------
+#if !defined(LUNCHBOX_NO_SIMD) && defined(__AVX512F__)
+	using BankLanes = Double8;
+#elif !defined(LUNCHBOX_NO_SIMD) && defined(__AVX__)
+	using BankLanes = Double4;
+#else
+	using BankLanes = Double2;
+#endif
+
+	//------------------------------------------------------------------------
+	//  LunchboxBank
+	//  numStrips stereo strips on one set of settings, run through Channel9,
+	//  EQ and MeowMu. The state is kept as structure of arrays: the channels
+	//  of all strips (L0 R0 L1 R1 ...) are packed BankLanes::kLanes at a
+	//  time into one state struct per group, so 4 strips share one AVX-512
+	//  pass and 2 strips one AVX pass. Every strip gives the same samples
+	//  as lunchboxProcessor::processChannel9/EQ/Comp on Sample64 with
+	//  Oversampling off and Detect on Stereo: the bank keeps both there,
+	//  whatever setParameter or a preset asks for.
+	//
+	//  Not a plug-in: for hosts that run many identical strips themselves.
+	//------------------------------------------------------------------------
+	class LunchboxBank
+	{
+	public:
+		explicit LunchboxBank(int32 numStrips);
+		~LunchboxBank();
+
+		LunchboxBank(const LunchboxBank&) = delete;
+		LunchboxBank& operator=(const LunchboxBank&) = delete;
+
+		/** Allocates everything, call before process and not from the audio thread. */
+		void setupProcessing(Vst::Sample64 sampleRate, int32 maxSamplesPerBlock);
+
+		/** Normalized value, the same parameter IDs as the plug-in. */
+		void setParameter(Vst::ParamID id, Vst::ParamValue value);
+
+		/** Settings from a plug-in state (preset) stream. */
+		tresult setState(IBStream* state);
+
+		/** Clears the filter and compressor state of all strips. */
+		void reset();
+
+		/** channels : 2 * numStrips buffers, L and R of strip 0 first, processed
+		    in place; longer blocks than maxSamplesPerBlock in pieces of it. */
+		template <typename SampleType>
+		void process(SampleType** channels, int32 sampleFrames);
+
+		/** libm sin in Channel9 instead of the polynomial, see lunchboxProcessor::setPreciseMath */
+		void setPreciseMath(bool state) { settings->setPreciseMath(state); }
+
+		int32 getNumStrips() const { return numStrips; }
+		static int32 getLaneCount() { return BankLanes::kLanes; }
+
+	protected:
+		int32 numStrips;
+		int32 numGroups;
+		Vst::Sample64 sampleRate = 44100.0;
+		int32 maxSamplesPerBlock = 0;
+
+		// holds the settings and works out the shared coefficients
+		lunchboxProcessor* settings = nullptr;
+
+		std::vector<Channel9State<BankLanes>> channel9;
+		std::vector<EQState<BankLanes>> eq;
+		std::vector<CompState<BankLanes>> comp;
+
+		// one group's block, lane-interleaved
+		std::vector<Vst::Sample64> lanes;
+
+		/** sampleFrames (at most maxSamplesPerBlock) of channels from offset on */
+		template <typename SampleType>
+		void processChunk(SampleType** channels, int32 offset, int32 sampleFrames);
+	};
+
+	//------------------------------------------------------------------------
+} // namespace yg331
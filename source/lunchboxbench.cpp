@@ -0,0 +1,555 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2023 yg331.
+//------------------------------------------------------------------------
+// Micro-benchmark: times each processX<SampleType> stage on its own and
+// the full process() chain, fused and per stage, per sample frame (both
+// channels); Mono is the fused chain on a mono bus, OS4x / OS4xFIR the
+// fused chain with 4x oversampling on the IIR / FIR filters. Strip and Bank compare Channel9 + EQ + MeowMu for one strip
+// with the same stages in LunchboxBank, per strip.
+//------------------------------------------------------------------------
+
+#include "lunchboxprocessor.h"
+#include "lunchboxbank.h"
+#include "lunchboxcids.h"
+#include "lunchboxdenormals.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define LUNCHBOX_HAVE_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define LUNCHBOX_HAVE_TSC 1
+#else
+#define LUNCHBOX_HAVE_TSC 0
+#endif
+
+using namespace Steinberg;
+using namespace yg331;
+
+namespace {
+
+	//------------------------------------------------------------------------
+	uint64 readCycles()
+	{
+#if LUNCHBOX_HAVE_TSC
+		return __rdtsc();
+#else
+		return 0;
+#endif
+	}
+
+	template <typename SampleType>
+	struct Stage
+	{
+		const char* name;
+		void (*run)(lunchboxProcessor* p, SampleType** buffers, Vst::Sample64 sampleRate, int32 frames);
+		void (*setup)(lunchboxProcessor* p) = nullptr;	// settings, once before the measurement
+	};
+
+	template <typename SampleType>
+	std::vector<Stage<SampleType>> getStages()
+	{
+		return {
+			{ "Input",     [](lunchboxProcessor* p, SampleType** b, Vst::Sample64 fs, int32 n) { p->processInput<SampleType>(b, b, fs, n); } },
+			{ "Channel9",  [](lunchboxProcessor* p, SampleType** b, Vst::Sample64 fs, int32 n) { p->processChannel9<SampleType>(b, b, fs, n); } },
+			{ "EQ",        [](lunchboxProcessor* p, SampleType** b, Vst::Sample64 fs, int32 n) { p->processEQ<SampleType>(b, b, fs, n); } },
+			{ "DeBess",    [](lunchboxProcessor* p, SampleType** b, Vst::Sample64 fs, int32 n) { p->processDeBess<SampleType>(b, b, fs, n); } },
+			{ "Comp",      [](lunchboxProcessor* p, SampleType** b, Vst::Sample64 fs, int32 n) { p->processComp<SampleType>(b, b, fs, n); } },
+			{ "CompEfficient", [](lunchboxProcessor* p, SampleType** b, Vst::Sample64 fs, int32 n) { p->processComp<SampleType>(b, b, fs, n); },
+				[](lunchboxProcessor* p) { p->setParameter(kParamCompMode, 1.0); } },
+			{ "Inflator",  [](lunchboxProcessor* p, SampleType** b, Vst::Sample64 fs, int32 n) { p->processInflator<SampleType>(b, b, fs, n); } },
+			{ "Limiter",   [](lunchboxProcessor* p, SampleType** b, Vst::Sample64 fs, int32 n) { p->processLimiter<SampleType>(b, b, fs, n); } },
+			{ "Gate",      [](lunchboxProcessor* p, SampleType** b, Vst::Sample64 fs, int32 n) { p->processGate<SampleType>(b, b, fs, n); } },
+			{ "Output",    [](lunchboxProcessor* p, SampleType** b, Vst::Sample64 fs, int32 n) {
+				p->processOutput<SampleType>(b, b, fs, n, (sizeof(SampleType) == sizeof(Vst::Sample32)) ? Vst::kSample32 : Vst::kSample64); } },
+		};
+	}
+
+	//------------------------------------------------------------------------
+	struct Options
+	{
+		std::vector<int32> blockSizes = { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+		std::vector<double> sampleRates = { 44100.0, 48000.0, 96000.0, 192000.0 };
+		std::string stage;         // empty : all stages and the chain
+		std::string type;          // empty : both
+		double seconds = 1.0;      // audio rendered per measurement
+		int32 repeats = 5;         // best of
+		int32 strips = 16;         // LunchboxBank size
+		const char* csvPath = nullptr;
+		const char* comparePath = nullptr;
+		bool precise = false;      // libm sin / cos in Channel9 and Gate
+		bool accuracy = false;     // only the fast math error against libm
+		bool denormals = false;    // only the decaying tail check
+	};
+
+	struct Result
+	{
+		std::string stage;
+		std::string type;
+		double sampleRate;
+		int32 blockSize;
+		double nsPerSample;
+		double cyclesPerSample;
+	};
+
+	std::string keyOf(const std::string& stage, const std::string& type, double fs, int32 block)
+	{
+		char key[128];
+		snprintf(key, sizeof(key), "%s/%s/%.0f/%d", stage.c_str(), type.c_str(), fs, block);
+		return key;
+	}
+
+	//------------------------------------------------------------------------
+	/** Deterministic programme material: two detuned voices, noise bursts and gaps. */
+	void makeSignal(std::vector<double>& left, std::vector<double>& right, double fs)
+	{
+		uint32 rng = 0x1234567;
+		for (size_t i = 0; i < left.size(); i++)
+		{
+			double t = i / fs;
+			rng = rng * 1664525u + 1013904223u;
+			double noise = (rng >> 8) / 16777216.0 - 0.5;
+			double env = (fmod(t, 0.5) < 0.4) ? 1.0 : 0.0;
+			double burst = (fmod(t, 0.25) < 0.03) ? 0.4 : 0.05;
+			left[i] = env * (0.5 * sin(2.0 * M_PI * 180.0 * t) + burst * noise);
+			right[i] = env * (0.45 * sin(2.0 * M_PI * 181.5 * t + 1.0) + burst * noise);
+		}
+	}
+
+	lunchboxProcessor* createProcessor(int32 symbolicSampleSize, int32 blockSize, double fs, bool precise,
+		Vst::SpeakerArrangement arr = Vst::SpeakerArr::kStereo)
+	{
+		lunchboxProcessor* p = new lunchboxProcessor;
+		p->initialize(nullptr);
+		p->setPreciseMath(precise);
+		p->setBusArrangements(&arr, 1, &arr, 1);
+		Vst::ProcessSetup setup;
+		setup.processMode = Vst::kOffline;
+		setup.symbolicSampleSize = symbolicSampleSize;
+		setup.maxSamplesPerBlock = blockSize;
+		setup.sampleRate = fs;
+		p->setupProcessing(setup);
+		p->setActive(true);
+		p->setProcessing(true);
+		return p;
+	}
+
+	void destroyProcessor(lunchboxProcessor* p)
+	{
+		p->setProcessing(false);
+		p->setActive(false);
+		p->terminate();
+		p->release();
+	}
+
+	//------------------------------------------------------------------------
+	/** Runs fn over the whole signal in blocks, best of o.repeats. */
+	template <typename SampleType, typename Fn>
+	void measure(const std::vector<double>& srcL, const std::vector<double>& srcR, int32 blockSize,
+		const Options& o, Fn fn, double& nsPerSample, double& cyclesPerSample)
+	{
+		const int32 total = (int32)srcL.size();
+		std::vector<SampleType> work[2];
+		work[0].resize(total);
+		work[1].resize(total);
+
+		// the single stages run outside process(), so set the FPU up as it does
+		ScopedDenormals noDenormals;
+
+		nsPerSample = 1e30;
+		cyclesPerSample = 1e30;
+		for (int32 r = 0; r <= o.repeats; r++)
+		{
+			for (int32 i = 0; i < total; i++) {
+				work[0][i] = (SampleType)srcL[i];
+				work[1][i] = (SampleType)srcR[i];
+			}
+
+			auto start = std::chrono::steady_clock::now();
+			uint64 c0 = readCycles();
+			for (int32 pos = 0; pos < total; pos += blockSize) {
+				int32 n = std::min(blockSize, total - pos);
+				SampleType* block[2] = { work[0].data() + pos, work[1].data() + pos };
+				fn(block, n);
+			}
+			uint64 c1 = readCycles();
+			auto stop = std::chrono::steady_clock::now();
+
+			if (r == 0) continue; // warm-up
+			double ns = std::chrono::duration<double, std::nano>(stop - start).count() / total;
+			double cy = (double)(c1 - c0) / total;
+			nsPerSample = std::min(nsPerSample, ns);
+			cyclesPerSample = std::min(cyclesPerSample, cy);
+		}
+	}
+
+	template <typename SampleType>
+	void runType(const char* typeName, const Options& o, std::vector<Result>& results)
+	{
+		const int32 symbolicSampleSize = (sizeof(SampleType) == sizeof(Vst::Sample32)) ? Vst::kSample32 : Vst::kSample64;
+
+		for (double fs : o.sampleRates)
+		{
+			std::vector<double> srcL((size_t)(fs * o.seconds)), srcR(srcL.size());
+			makeSignal(srcL, srcR, fs);
+
+			for (int32 blockSize : o.blockSizes)
+			{
+				for (const auto& stage : getStages<SampleType>())
+				{
+					if (!o.stage.empty() && o.stage != stage.name) continue;
+
+					lunchboxProcessor* p = createProcessor(symbolicSampleSize, blockSize, fs, o.precise);
+					if (stage.setup) stage.setup(p);
+					Result r{ stage.name, typeName, fs, blockSize, 0.0, 0.0 };
+					measure<SampleType>(srcL, srcR, blockSize, o,
+						[&](SampleType** b, int32 n) { stage.run(p, b, fs, n); },
+						r.nsPerSample, r.cyclesPerSample);
+					destroyProcessor(p);
+					results.push_back(r);
+				}
+
+				// full chain through process(), as a host would call it, with the
+				// fused kernel (Chain), with one pass per stage (Staged), fused
+				// on a mono bus (Mono, the left channel only) and oversampled
+				for (const char* name : { "Chain", "Staged", "Mono", "OS4x", "OS4xFIR" })
+				{
+					if (!o.stage.empty() && o.stage != name) continue;
+					const bool fused = strcmp(name, "Staged") != 0;
+					const bool mono = strcmp(name, "Mono") == 0;
+					const bool oversampled = strncmp(name, "OS4x", 4) == 0;
+
+					lunchboxProcessor* p = createProcessor(symbolicSampleSize, blockSize, fs, o.precise,
+						mono ? Vst::SpeakerArr::kMono : Vst::SpeakerArr::kStereo);
+					p->setFusedKernel(fused);
+					if (oversampled) {
+						p->setParameter(kParamOversampling, (double)kOversampling4x / (kNumOversamplings - 1));
+						p->setParameter(kParamOversamplingFilter, strcmp(name, "OS4xFIR") == 0 ? 1.0 : 0.0);
+					}
+					std::vector<SampleType> outL(blockSize), outR(blockSize);
+					SampleType* out[2] = { outL.data(), outR.data() };
+					Result r{ name, typeName, fs, blockSize, 0.0, 0.0 };
+					measure<SampleType>(srcL, srcR, blockSize, o,
+						[&](SampleType** b, int32 n) {
+							Vst::AudioBusBuffers inBus, outBus;
+							inBus.numChannels = outBus.numChannels = mono ? 1 : 2;
+							inBus.silenceFlags = outBus.silenceFlags = 0;
+							if (symbolicSampleSize == Vst::kSample32) {
+								inBus.channelBuffers32 = (Vst::Sample32**)b;
+								outBus.channelBuffers32 = (Vst::Sample32**)out;
+							}
+							else {
+								inBus.channelBuffers64 = (Vst::Sample64**)b;
+								outBus.channelBuffers64 = (Vst::Sample64**)out;
+							}
+							Vst::ProcessData data;
+							data.processMode = Vst::kOffline;
+							data.symbolicSampleSize = symbolicSampleSize;
+							data.numSamples = n;
+							data.numInputs = 1;
+							data.numOutputs = 1;
+							data.inputs = &inBus;
+							data.outputs = &outBus;
+							p->process(data);
+						},
+						r.nsPerSample, r.cyclesPerSample);
+					destroyProcessor(p);
+					results.push_back(r);
+				}
+
+				// Channel9 + EQ + MeowMu of one strip, and the same per strip
+				// in a bank of o.strips strips on the same settings
+				if (o.stage.empty() || o.stage == "Strip")
+				{
+					lunchboxProcessor* p = createProcessor(symbolicSampleSize, blockSize, fs, o.precise);
+					Result r{ "Strip", typeName, fs, blockSize, 0.0, 0.0 };
+					measure<SampleType>(srcL, srcR, blockSize, o,
+						[&](SampleType** b, int32 n) {
+							p->processChannel9<SampleType>(b, b, fs, n);
+							p->processEQ<SampleType>(b, b, fs, n);
+							p->processComp<SampleType>(b, b, fs, n);
+						},
+						r.nsPerSample, r.cyclesPerSample);
+					destroyProcessor(p);
+					results.push_back(r);
+				}
+				if (o.stage.empty() || o.stage == "Bank")
+				{
+					LunchboxBank bank(o.strips);
+					bank.setPreciseMath(o.precise);
+					bank.setupProcessing(fs, blockSize);
+					std::vector<SampleType> strips((size_t)2 * o.strips * blockSize);
+					std::vector<SampleType*> channels(2 * o.strips);
+					for (int32 c = 0; c < 2 * o.strips; c++) channels[c] = strips.data() + (size_t)c * blockSize;
+					Result r{ "Bank", typeName, fs, blockSize, 0.0, 0.0 };
+					measure<SampleType>(srcL, srcR, blockSize, o,
+						[&](SampleType** b, int32 n) {
+							for (int32 c = 0; c < 2 * o.strips; c++)
+								memcpy(channels[c], b[c & 1], n * sizeof(SampleType));
+							bank.process<SampleType>(channels.data(), n);
+							memcpy(b[0], channels[0], n * sizeof(SampleType));
+							memcpy(b[1], channels[1], n * sizeof(SampleType));
+						},
+						r.nsPerSample, r.cyclesPerSample);
+					r.nsPerSample /= o.strips;
+					r.cyclesPerSample /= o.strips;
+					results.push_back(r);
+				}
+			}
+		}
+	}
+
+	//------------------------------------------------------------------------
+	bool loadBaseline(const char* path, std::map<std::string, double>& baseline)
+	{
+		FILE* f = fopen(path, "r");
+		if (!f) return false;
+		char line[256];
+		while (fgets(line, sizeof(line), f))
+		{
+			char stage[64], type[16];
+			double fs, ns, cy;
+			int block;
+			if (sscanf(line, "%63[^,],%15[^,],%lf,%d,%lf,%lf", stage, type, &fs, &block, &ns, &cy) == 6)
+				baseline[keyOf(stage, type, fs, block)] = ns;
+		}
+		fclose(f);
+		return true;
+	}
+
+	std::vector<int32> parseIntList(const char* s)
+	{
+		std::vector<int32> v;
+		for (const char* p = s; *p; ) {
+			v.push_back(atoi(p));
+			p = strchr(p, ',');
+			if (!p) break;
+			p++;
+		}
+		return v;
+	}
+
+	void printUsage()
+	{
+		fprintf(stderr,
+			"usage: airwindows_500_lunchbox_bench [options]\n"
+			"\n"
+			"  --stage <name>       Input|Channel9|EQ|DeBess|Comp|CompEfficient|Inflator|Limiter|Gate|Output|\n"
+			"                       Chain|Staged|Mono|OS4x|OS4xFIR|Strip|Bank\n"
+			"  --type 32|64         only Sample32 or Sample64\n"
+			"  --blocks a,b,...     block sizes (default 16,32,...,4096)\n"
+			"  --rates a,b,...      sample rates (default 44100,48000,96000,192000)\n"
+			"  --seconds <s>        audio per measurement (default 1)\n"
+			"  --repeats <n>        best of n runs (default 5)\n"
+			"  --strips <n>         strips in the Bank measurement (default 16)\n"
+			"  --csv <file>         write results as CSV (a baseline for --compare)\n"
+			"  --compare <file>     print the change against a saved baseline\n"
+			"  --precise            libm sin / cos in Channel9 and Gate, not the polynomials\n"
+			"  --accuracy           only print the error of the polynomials against libm\n"
+			"  --denormals          only check decaying tails for CPU spikes, exits 1 on a spike\n");
+	}
+
+	//------------------------------------------------------------------------
+	/** Largest error of fn against ref over n points of [from, to], in the lanes of V */
+	template <typename V, typename Fn, typename Ref>
+	void printAccuracy(const char* name, double from, double to, Fn fn, Ref ref)
+	{
+		const int32 n = 4000000;
+		double maxError = 0.0, at = from, maxRelative = 0.0;
+		for (int32 i = 0; i < n; i += V::kLanes)
+		{
+			double x[V::kLanes], y[V::kLanes];
+			for (int k = 0; k < V::kLanes; k++) x[k] = from + (to - from) * (i + k) / (n - 1);
+			fn(V::load(x)).store(y);
+			for (int k = 0; k < V::kLanes; k++) {
+				double exact = ref(x[k]);
+				double error = fabs(y[k] - exact);
+				if (error > maxError) { maxError = error; at = x[k]; }
+				if (fabs(exact) > 1e-3) maxRelative = std::max(maxRelative, error / fabs(exact));
+			}
+		}
+		printf("%-8s %+.4f .. %+.4f  max error %.2e (%.1f dB) at %+.6f, relative %.2e\n", name, from, to,
+			maxError, 20.0 * log10(maxError), at, maxRelative);
+	}
+
+	int runAccuracy()
+	{
+		const double pi = 3.14159265358979323846;
+		printf("fast math against libm, %d lanes:\n", Double2::kLanes);
+		printAccuracy<Double2>("sinFast", -pi / 2, pi / 2,
+			[](const Double2& x) { return sinFast(x); }, [](double x) { return sin(x); });
+		printAccuracy<Double2>("versine", -pi, pi,
+			[](const Double2& x) { return versineFast(x); }, [](double x) { return 1.0 - cos(x); });
+		return 0;
+	}
+
+	//------------------------------------------------------------------------
+	/** Decaying tails through process(): a burst, then an exponential fade
+	    from -6 dBFS down past the smallest double, 10 s at 48 kHz in blocks
+	    of 256, every block timed. The fade crosses the float denormals after
+	    about 1.5 s and the double ones after about 8 s, and every filter in the
+	    chain rings down through them. Each quarter second is rated by the
+	    median of its block times against the burst; denormal arithmetic shows
+	    as a quarter running several times slower. Returns 1 past 2x. */
+	template <typename SampleType>
+	int runDenormals(const char* typeName)
+	{
+		const int32 symbolicSampleSize = (sizeof(SampleType) == sizeof(Vst::Sample32)) ? Vst::kSample32 : Vst::kSample64;
+		const double fs = 48000.0;
+		const int32 blockSize = 256;
+		const int32 total = (int32)(fs * 10.0);
+		const double burst = 0.5;							// s at full level
+		const double tau = 8.0 / (log(0.5) - log(1e-320));	// fade time constant
+
+		std::vector<SampleType> input[2], output[2];
+		for (int c = 0; c < 2; c++) {
+			input[c].resize(total);
+			output[c].resize(blockSize);
+		}
+		for (int32 i = 0; i < total; i++) {
+			double t = i / fs;
+			double level = (t < burst) ? 0.5 : 0.5 * exp(-(t - burst) / tau);
+			input[0][i] = (SampleType)(level * sin(2.0 * M_PI * 180.0 * t));
+			input[1][i] = (SampleType)(level * sin(2.0 * M_PI * 181.5 * t + 1.0));
+		}
+
+		lunchboxProcessor* p = createProcessor(symbolicSampleSize, blockSize, fs, false);
+		std::vector<double> blockNs;
+		for (int32 pos = 0; pos < total; pos += blockSize)
+		{
+			int32 n = std::min(blockSize, total - pos);
+			SampleType* in[2] = { input[0].data() + pos, input[1].data() + pos };
+			SampleType* out[2] = { output[0].data(), output[1].data() };
+			Vst::AudioBusBuffers inBus, outBus;
+			inBus.numChannels = outBus.numChannels = 2;
+			inBus.silenceFlags = outBus.silenceFlags = 0;
+			if (symbolicSampleSize == Vst::kSample32) {
+				inBus.channelBuffers32 = (Vst::Sample32**)in;
+				outBus.channelBuffers32 = (Vst::Sample32**)out;
+			}
+			else {
+				inBus.channelBuffers64 = (Vst::Sample64**)in;
+				outBus.channelBuffers64 = (Vst::Sample64**)out;
+			}
+			Vst::ProcessData data;
+			data.processMode = Vst::kOffline;
+			data.symbolicSampleSize = symbolicSampleSize;
+			data.numSamples = n;
+			data.numInputs = 1;
+			data.numOutputs = 1;
+			data.inputs = &inBus;
+			data.outputs = &outBus;
+
+			auto start = std::chrono::steady_clock::now();
+			p->process(data);
+			auto stop = std::chrono::steady_clock::now();
+			blockNs.push_back(std::chrono::duration<double, std::nano>(stop - start).count() / n);
+		}
+		destroyProcessor(p);
+
+		auto median = [&](size_t from, size_t to) {
+			std::vector<double> v(blockNs.begin() + from, blockNs.begin() + std::min(to, blockNs.size()));
+			std::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+			return v[v.size() / 2];
+		};
+		const size_t quarter = (size_t)(fs * 0.25) / blockSize;
+		const double reference = median(0, (size_t)(fs * burst) / blockSize);
+		double worst = 0.0, worstAt = 0.0;
+		for (size_t from = 0; from < blockNs.size(); from += quarter) {
+			double ratio = median(from, from + quarter) / reference;
+			if (ratio > worst) { worst = ratio; worstAt = from * blockSize / fs; }
+		}
+
+		const bool spike = worst > 2.0;
+		printf("%s decaying tail: burst %.1f ns/sample, slowest quarter second %.2fx at %.2f s %s\n",
+			typeName, reference, worst, worstAt, spike ? "SPIKE" : "ok");
+		return spike ? 1 : 0;
+	}
+
+} // namespace
+
+//------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	Options o;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string a = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (a == "--stage" && hasValue) o.stage = argv[++i];
+		else if (a == "--type" && hasValue) o.type = argv[++i];
+		else if (a == "--blocks" && hasValue) o.blockSizes = parseIntList(argv[++i]);
+		else if (a == "--rates" && hasValue) {
+			o.sampleRates.clear();
+			for (int32 r : parseIntList(argv[++i])) o.sampleRates.push_back(r);
+		}
+		else if (a == "--seconds" && hasValue) o.seconds = atof(argv[++i]);
+		else if (a == "--repeats" && hasValue) o.repeats = std::max(1, atoi(argv[++i]));
+		else if (a == "--strips" && hasValue) o.strips = std::max(1, atoi(argv[++i]));
+		else if (a == "--csv" && hasValue) o.csvPath = argv[++i];
+		else if (a == "--compare" && hasValue) o.comparePath = argv[++i];
+		else if (a == "--precise") o.precise = true;
+		else if (a == "--accuracy") o.accuracy = true;
+		else if (a == "--denormals") o.denormals = true;
+		else {
+			printUsage();
+			return 2;
+		}
+	}
+
+	if (o.accuracy)
+		return runAccuracy();
+	if (o.denormals) {
+		int failed = 0;
+		if (o.type.empty() || o.type == "32") failed |= runDenormals<Vst::Sample32>("Sample32");
+		if (o.type.empty() || o.type == "64") failed |= runDenormals<Vst::Sample64>("Sample64");
+		return failed;
+	}
+
+	std::map<std::string, double> baseline;
+	if (o.comparePath && !loadBaseline(o.comparePath, baseline)) {
+		fprintf(stderr, "cannot read %s\n", o.comparePath);
+		return 1;
+	}
+
+	std::vector<Result> results;
+	if (o.type.empty() || o.type == "32") runType<Vst::Sample32>("Sample32", o, results);
+	if (o.type.empty() || o.type == "64") runType<Vst::Sample64>("Sample64", o, results);
+
+	printf("%-10s %-9s %8s %6s %10s %12s%s\n", "stage", "type", "rate", "block", "ns/sample",
+		LUNCHBOX_HAVE_TSC ? "cycles/sample" : "cycles/sample(n/a)", baseline.empty() ? "" : "   vs baseline");
+	for (const auto& r : results)
+	{
+		printf("%-10s %-9s %8.0f %6d %10.2f %12.1f", r.stage.c_str(), r.type.c_str(), r.sampleRate, r.blockSize,
+			r.nsPerSample, r.cyclesPerSample);
+		auto it = baseline.find(keyOf(r.stage, r.type, r.sampleRate, r.blockSize));
+		if (it != baseline.end() && it->second > 0.0)
+			printf("   %+6.1f%%", 100.0 * (r.nsPerSample - it->second) / it->second);
+		printf("\n");
+	}
+
+	if (o.csvPath)
+	{
+		FILE* f = fopen(o.csvPath, "w");
+		if (!f) {
+			fprintf(stderr, "cannot write %s\n", o.csvPath);
+			return 1;
+		}
+		fprintf(f, "stage,type,rate,block,ns_per_sample,cycles_per_sample\n");
+		for (const auto& r : results)
+			fprintf(f, "%s,%s,%.0f,%d,%.4f,%.4f\n", r.stage.c_str(), r.type.c_str(), r.sampleRate, r.blockSize,
+				r.nsPerSample, r.cyclesPerSample);
+		fclose(f);
+	}
+	return 0;
+}
@@ -13,6 +13,13 @@ namespace yg331 {
 	static const Steinberg::FUID klunchboxProcessorUID(0x9B16F1C8, 0x51FB52B3, 0xBD5826BA, 0x9E94BA87);
 	static const Steinberg::FUID klunchboxControllerUID(0xEE704E30, 0xAD1E5A10, 0xA5754B21, 0xFE1E9419);
 
+	// Latency handshake: after the controller changes Safe, Oversampling or
+	// OS Filter it asks (kLatencyRequestMessage) until the processor has
+	// taken the change and answers kLatencyChangedMessage, and only then
+	// tells the host to ask for the latency again
+	static const char* const kLatencyRequestMessage = "LunchboxLatencyRequest";
+	static const char* const kLatencyChangedMessage = "LunchboxLatencyChanged";
+
 #define lunchboxVST3Category "Fx"
 
 	//------------------------------------------------------------------------
@@ -45,7 +52,71 @@ namespace yg331 {
 		kParamInVuPPM,
 		kParamOutVuPPM,
 		kParamDeEssVuPPM,
-		kParamCompVuPPM
+		kParamCompVuPPM,
+
+		kParamDetect,
+		kParamOversampling,
+		kParamOversamplingFilter,
+
+		// read only like the VuPPMs, filled from the meter frames (lunchboxmeter.h)
+		kParamInRMS,
+		kParamOutRMS,
+		kParamOutTruePeak,
+
+		// read only, output loudness in LUFS / LU (lunchboxloudness.h)
+		kParamMomentary,
+		kParamShortTerm,
+		kParamIntegrated,
+		kParamLoudnessRange,
+
+		kParamCompMode,
+		kParamSidechain
+	};
+
+	// How DeBess and MeowMu detect a channel pair (kParamDetect, a list)
+	enum {
+		kDetectStereo = 0,	// left and right on their own
+		kDetectLinked,		// one detector, the louder channel
+		kDetectMidSide,		// processed as mid and side
+		kDetectMonoSum,		// one detector on (L + R) / 2
+
+		kNumDetectModes
+	};
+
+	// The MeowMu engine (kParamCompMode, a list)
+	enum {
+		kCompVintage = 0,	// the vari-mu state machine, sample by sample
+		kCompEfficient,		// a block-based follower, see lunchboxkernels.h
+
+		kNumCompModes
+	};
+
+	// What the sidechain input keys (kParamSidechain, a list), one bit per stage
+	enum {
+		kSidechainOff = 0,
+		kSidechainComp = 1,		// MeowMu
+		kSidechainGate = 2,		// the Gate
+		kSidechainBoth = kSidechainComp | kSidechainGate,
+
+		kNumSidechainModes
+	};
+
+	// Oversampling of Channel9, Inflator and Gate (kParamOversampling, a list)
+	enum {
+		kOversamplingOff = 0,
+		kOversampling2x,
+		kOversampling4x,
+		kOversampling8x,
+
+		kNumOversamplings
+	};
+
+	// Half-band filters of the oversampling (kParamOversamplingFilter, a list)
+	enum {
+		kFilterLowLatency = 0,	// polyphase IIR, a few samples, not linear phase
+		kFilterLinearPhase,		// polyphase FIR, linear phase
+
+		kNumOversamplingFilters
 	};
 
 	const bool BypassInit = false, 
@@ -54,6 +125,12 @@ namespace yg331 {
 		AttackInit = false, 
 		SafeInit = false;
 
+	const Steinberg::int32 DetectInit = kDetectStereo,
+		CompModeInit = kCompVintage,
+		SidechainInit = kSidechainOff,
+		OversamplingInit = kOversamplingOff,
+		OversamplingFilterInit = kFilterLowLatency;
+
 	const double InputInit = 0.5,
 		OutputInit = 0.5,
 
@@ -7,9 +7,13 @@
 #include "vstgui/plugin-bindings/vst3editor.h"
 #include "pluginterfaces/base/ustring.h"
 #include "base/source/fstreamer.h"
+#include "pluginterfaces/vst/ivstmessage.h"
 
 #include "public.sdk/source/vst/vsteditcontroller.h"
 
+#include <algorithm>
+#include <cstring>
+
 using namespace Steinberg;
 
 namespace yg331 {
@@ -60,6 +64,32 @@ namespace yg331 {
 		tag = kParamOutVuPPM;
 		auto* OutVuPPM = new VuPPMParameter(USTRING("OutVuPPM"), flags, tag, STR16("dB"), minPlain, maxPlain, defaultPlain);
 		parameters.addParameter(OutVuPPM);
+		tag = kParamInRMS;
+		auto* InRMS = new VuPPMParameter(USTRING("InRMS"), flags, tag, STR16("dB"), minPlain, maxPlain, defaultPlain);
+		parameters.addParameter(InRMS);
+		tag = kParamOutRMS;
+		auto* OutRMS = new VuPPMParameter(USTRING("OutRMS"), flags, tag, STR16("dB"), minPlain, maxPlain, defaultPlain);
+		parameters.addParameter(OutRMS);
+		tag = kParamOutTruePeak;
+		auto* OutTruePeak = new VuPPMParameter(USTRING("OutTruePeak"), flags, tag, STR16("dB"), minPlain, maxPlain, defaultPlain);
+		parameters.addParameter(OutTruePeak);
+
+		minPlain = -60;
+		maxPlain = 0;
+		defaultPlain = -60;
+
+		tag = kParamMomentary;
+		auto* Momentary = new SliderParameter(USTRING("Momentary"), tag, STR16("LUFS"), minPlain, maxPlain, defaultPlain, 0, flags);
+		parameters.addParameter(Momentary);
+		tag = kParamShortTerm;
+		auto* ShortTerm = new SliderParameter(USTRING("ShortTerm"), tag, STR16("LUFS"), minPlain, maxPlain, defaultPlain, 0, flags);
+		parameters.addParameter(ShortTerm);
+		tag = kParamIntegrated;
+		auto* Integrated = new SliderParameter(USTRING("Integrated"), tag, STR16("LUFS"), minPlain, maxPlain, defaultPlain, 0, flags);
+		parameters.addParameter(Integrated);
+		tag = kParamLoudnessRange;
+		auto* LoudnessRange = new SliderParameter(USTRING("LoudnessRange"), tag, STR16("LU"), 0.0, 30.0, 0.0, 0, flags);
+		parameters.addParameter(LoudnessRange);
 
 		minPlain = -12;
 		maxPlain = 0;
@@ -162,12 +192,54 @@ namespace yg331 {
 		defaultVal = 0;
 		flags = Vst::ParameterInfo::kCanAutomate;
 		parameters.addParameter(STR16("Attack"), nullptr, stepCount, defaultVal, flags, tag);
-		tag = kParamSafe;
+		tag = kParamSafe;	// the limiter's lookahead changes the latency, not automated
 		stepCount = 1;
 		defaultVal = 0;
-		flags = Vst::ParameterInfo::kCanAutomate;
+		flags = 0;
 		parameters.addParameter(STR16("Safe"), nullptr, stepCount, defaultVal, flags, tag);
 
+		tag = kParamDetect;
+		flags = Vst::ParameterInfo::kCanAutomate | Vst::ParameterInfo::kIsList;
+		auto* detectParam = new Vst::StringListParameter(STR16("Detect"), tag, nullptr, flags);
+		detectParam->appendString(STR16("Stereo"));
+		detectParam->appendString(STR16("Linked"));
+		detectParam->appendString(STR16("Mid/Side"));
+		detectParam->appendString(STR16("Mono Sum"));
+		parameters.addParameter(detectParam);
+
+		tag = kParamCompMode;
+		flags = Vst::ParameterInfo::kCanAutomate | Vst::ParameterInfo::kIsList;
+		auto* compModeParam = new Vst::StringListParameter(STR16("Comp Mode"), tag, nullptr, flags);
+		compModeParam->appendString(STR16("Vintage"));
+		compModeParam->appendString(STR16("Efficient"));
+		parameters.addParameter(compModeParam);
+
+		tag = kParamSidechain;
+		flags = Vst::ParameterInfo::kCanAutomate | Vst::ParameterInfo::kIsList;
+		auto* sidechainParam = new Vst::StringListParameter(STR16("Sidechain"), tag, nullptr, flags);
+		sidechainParam->appendString(STR16("Off"));
+		sidechainParam->appendString(STR16("Comp"));
+		sidechainParam->appendString(STR16("Gate"));
+		sidechainParam->appendString(STR16("Comp + Gate"));
+		parameters.addParameter(sidechainParam);
+
+		// these change the latency, so they are not automated
+		tag = kParamOversampling;
+		flags = Vst::ParameterInfo::kIsList;
+		auto* oversamplingParam = new Vst::StringListParameter(STR16("Oversampling"), tag, nullptr, flags);
+		oversamplingParam->appendString(STR16("Off"));
+		oversamplingParam->appendString(STR16("2x"));
+		oversamplingParam->appendString(STR16("4x"));
+		oversamplingParam->appendString(STR16("8x"));
+		parameters.addParameter(oversamplingParam);
+
+		tag = kParamOversamplingFilter;
+		flags = Vst::ParameterInfo::kIsList;
+		auto* filterParam = new Vst::StringListParameter(STR16("OS Filter"), tag, nullptr, flags);
+		filterParam->appendString(STR16("Low Latency"));
+		filterParam->appendString(STR16("Linear Phase"));
+		parameters.addParameter(filterParam);
+
 
 		tag = kParamBypass;
 		stepCount = 1;
@@ -184,6 +256,16 @@ namespace yg331 {
 	tresult PLUGIN_API lunchboxController::terminate()
 	{
 		// Here the Plug-in will be de-instantiated, last possibility to remove some memory!
+		if (meterTimer)
+		{
+			meterTimer->stop();
+			meterTimer = nullptr;
+		}
+		if (latencyTimer)
+		{
+			latencyTimer->stop();
+			latencyTimer = nullptr;
+		}
 
 		//---do not forget to call parent ------
 		return EditControllerEx1::terminate();
@@ -299,6 +381,32 @@ namespace yg331 {
 			return kResultFalse;
 		setParamNormalized(kParamBypass, savedBypass);
 
+		// appended later, older states end here
+		int32 savedDetect = DetectInit;
+		if (streamer.readInt32(savedDetect) == false)
+			savedDetect = DetectInit;
+		setParamNormalized(kParamDetect, (Vst::ParamValue)savedDetect / (kNumDetectModes - 1));
+
+		int32 savedOversampling = OversamplingInit;
+		if (streamer.readInt32(savedOversampling) == false)
+			savedOversampling = OversamplingInit;
+		setParamNormalized(kParamOversampling, (Vst::ParamValue)savedOversampling / (kNumOversamplings - 1));
+
+		int32 savedOversamplingFilter = OversamplingFilterInit;
+		if (streamer.readInt32(savedOversamplingFilter) == false)
+			savedOversamplingFilter = OversamplingFilterInit;
+		setParamNormalized(kParamOversamplingFilter, (Vst::ParamValue)savedOversamplingFilter / (kNumOversamplingFilters - 1));
+
+		int32 savedCompMode = CompModeInit;
+		if (streamer.readInt32(savedCompMode) == false)
+			savedCompMode = CompModeInit;
+		setParamNormalized(kParamCompMode, (Vst::ParamValue)savedCompMode / (kNumCompModes - 1));
+
+		int32 savedSidechain = SidechainInit;
+		if (streamer.readInt32(savedSidechain) == false)
+			savedSidechain = SidechainInit;
+		setParamNormalized(kParamSidechain, (Vst::ParamValue)savedSidechain / (kNumSidechainModes - 1));
+
 		return kResultOk;
 	}
 
@@ -336,10 +444,141 @@ namespace yg331 {
 	tresult PLUGIN_API lunchboxController::setParamNormalized(Vst::ParamID tag, Vst::ParamValue value)
 	{
 		// called by host to update your parameters
+		bool latencyChanged = (tag == kParamSafe || tag == kParamOversampling || tag == kParamOversamplingFilter) && getParamNormalized(tag) != value;
 		tresult result = EditControllerEx1::setParamNormalized(tag, value);
+
+		// the processor only takes the new value with its next process call:
+		// ask it until it has, the host is told in notify()
+		if (latencyChanged && result == kResultTrue)
+		{
+			latencyPolls = kLatencyPolls;
+			if (!latencyTimer)
+				latencyTimer = owned(Timer::create(this, kMeterRequestMs));
+		}
 		return result;
 	}
 
+	//------------------------------------------------------------------------
+	void lunchboxController::editorAttached(Vst::EditorView* editor)
+	{
+		// the meters only run while an editor shows them
+		if (openEditors++ == 0 && !meterTimer)
+			meterTimer = owned(Timer::create(this, kMeterRequestMs));
+		EditControllerEx1::editorAttached(editor);
+	}
+
+	//------------------------------------------------------------------------
+	void lunchboxController::editorRemoved(Vst::EditorView* editor)
+	{
+		if (--openEditors == 0 && meterTimer)
+		{
+			meterTimer->stop();
+			meterTimer = nullptr;
+		}
+		EditControllerEx1::editorRemoved(editor);
+	}
+
+	//------------------------------------------------------------------------
+	void lunchboxController::onTimer(Timer* timer)
+	{
+		if (timer == latencyTimer)
+		{
+			// a change that leaves the latency as it was is never answered
+			if (--latencyPolls < 0)
+			{
+				latencyTimer->stop();
+				latencyTimer = nullptr;
+				return;
+			}
+			if (IPtr<Vst::IMessage> message = owned(allocateMessage()))
+			{
+				message->setMessageID(kLatencyRequestMessage);
+				sendMessage(message);
+			}
+			return;
+		}
+
+		// asks the processor for the frames metered since the last request,
+		// the answer comes back in notify()
+		if (IPtr<Vst::IMessage> message = owned(allocateMessage()))
+		{
+			message->setMessageID(kMeterRequestMessage);
+			sendMessage(message);
+		}
+	}
+
+	//------------------------------------------------------------------------
+	tresult PLUGIN_API lunchboxController::notify(Vst::IMessage* message)
+	{
+		if (message && strcmp(message->getMessageID(), kLatencyChangedMessage) == 0)
+		{
+			// the processor has the new latency, the host asks for it
+			if (latencyTimer)
+			{
+				latencyTimer->stop();
+				latencyTimer = nullptr;
+			}
+			if (componentHandler)
+				componentHandler->restartComponent(Vst::kLatencyChanged);
+			return kResultOk;
+		}
+		if (!message || strcmp(message->getMessageID(), kMeterFramesMessage) != 0)
+			return EditControllerEx1::notify(message);
+
+		const void* data = nullptr;
+		uint32 size = 0;
+		if (message->getAttributes()->getBinary(kMeterFramesAttribute, data, size) != kResultTrue)
+			return kResultFalse;
+		updateMeters(static_cast<const MeterFrame*>(data), size / sizeof(MeterFrame));
+		return kResultOk;
+	}
+
+	//------------------------------------------------------------------------
+	void lunchboxController::updateMeters(const MeterFrame* frames, int32 numFrames)
+	{
+		if (numFrames <= 0)
+			return;
+
+		// peaks and gain reduction hold their extreme over the frames since
+		// the last refresh, RMS and loudness show the latest frame
+		MeterFrame held = frames[numFrames - 1];
+		for (int32 i = 0; i < numFrames; i++)
+		{
+			const MeterFrame& frame = frames[i];
+			held.inPeak = std::max(held.inPeak, frame.inPeak);
+			held.outPeak = std::max(held.outPeak, frame.outPeak);
+			held.outTruePeak = std::max(held.outTruePeak, frame.outTruePeak);
+			held.deEssGain = std::min(held.deEssGain, frame.deEssGain);
+			held.compGain = std::min(held.compGain, frame.compGain);
+
+			meterHistory[meterHistoryPos] = frame;
+			meterHistoryPos = (meterHistoryPos + 1) % kMeterHistoryFrames;
+			meterHistorySize = std::min(meterHistorySize + 1, kMeterHistoryFrames);
+		}
+
+		auto setMeter = [&](Vst::ParamID tag, float linear) {
+			if (Vst::Parameter* param = getParameterObject(tag))
+				setParamNormalized(tag, param->toNormalized(linear));
+		};
+		setMeter(kParamInVuPPM, held.inPeak);
+		setMeter(kParamOutVuPPM, held.outPeak);
+		setMeter(kParamInRMS, held.inRms);
+		setMeter(kParamOutRMS, held.outRms);
+		setMeter(kParamOutTruePeak, held.outTruePeak);
+		setMeter(kParamDeEssVuPPM, held.deEssGain);
+		setMeter(kParamCompVuPPM, held.compGain);
+
+		// loudness as it stands after the latest frame, in LUFS / LU
+		auto setLoudness = [&](Vst::ParamID tag, float plain) {
+			if (Vst::Parameter* param = getParameterObject(tag))
+				setParamNormalized(tag, std::min(std::max(param->toNormalized(plain), 0.0), 1.0));
+		};
+		setLoudness(kParamMomentary, held.momentary);
+		setLoudness(kParamShortTerm, held.shortTerm);
+		setLoudness(kParamIntegrated, held.integrated);
+		setLoudness(kParamLoudnessRange, held.loudnessRange);
+	}
+
 	//------------------------------------------------------------------------
 	tresult PLUGIN_API lunchboxController::getParamStringByValue(Vst::ParamID tag, Vst::ParamValue valueNormalized, Vst::String128 string)
 	{
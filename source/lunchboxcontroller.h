@@ -5,6 +5,8 @@
 #pragma once
 
 #include "public.sdk/source/vst/vsteditcontroller.h"
+#include "base/source/timer.h"
+#include "lunchboxmeter.h"
 
 using namespace Steinberg;
 
@@ -13,7 +15,7 @@ namespace yg331 {
 	//------------------------------------------------------------------------
 	//  lunchboxController
 	//------------------------------------------------------------------------
-	class lunchboxController : public Steinberg::Vst::EditControllerEx1
+	class lunchboxController : public Steinberg::Vst::EditControllerEx1, public Steinberg::ITimerCallback
 	{
 	public:
 		//------------------------------------------------------------------------
@@ -43,6 +45,21 @@ namespace yg331 {
 		Steinberg::tresult PLUGIN_API getParamValueByString(Steinberg::Vst::ParamID tag,
 			Steinberg::Vst::TChar* string,
 			Steinberg::Vst::ParamValue& valueNormalized) SMTG_OVERRIDE;
+		void editorAttached(Steinberg::Vst::EditorView* editor) SMTG_OVERRIDE;
+		void editorRemoved(Steinberg::Vst::EditorView* editor) SMTG_OVERRIDE;
+
+		// ComponentBase
+		Steinberg::tresult PLUGIN_API notify(Steinberg::Vst::IMessage* message) SMTG_OVERRIDE;
+
+		// ITimerCallback
+		void onTimer(Steinberg::Timer* timer) SMTG_OVERRIDE;
+
+		/** Meter frames received so far, at most kMeterHistoryFrames, age 0 : the latest */
+		Steinberg::int32 getMeterHistorySize() const { return meterHistorySize; }
+		const MeterFrame& getMeterHistory(Steinberg::int32 age) const
+		{
+			return meterHistory[(meterHistoryPos + kMeterHistoryFrames - 1 - age) % kMeterHistoryFrames];
+		}
 
 		//---Interface---------
 		DEFINE_INTERFACES
@@ -53,6 +70,23 @@ namespace yg331 {
 
 			//------------------------------------------------------------------------
 	protected:
+		// 3 s of kMeterFrameMs frames, for the gain reduction history
+		static constexpr Steinberg::int32 kMeterHistoryFrames = 300;
+		// how long to ask for a new latency, in kMeterRequestMs: about 2 s
+		static constexpr Steinberg::int32 kLatencyPolls = 66;
+
+		void updateMeters(const MeterFrame* frames, Steinberg::int32 numFrames);
+
+		Steinberg::IPtr<Steinberg::Timer> meterTimer;
+		Steinberg::int32 openEditors = 0;
+
+		// asks for kLatencyChangedMessage after Safe, Oversampling or OS Filter changed
+		Steinberg::IPtr<Steinberg::Timer> latencyTimer;
+		Steinberg::int32 latencyPolls = 0;
+
+		MeterFrame meterHistory[kMeterHistoryFrames] = {};
+		Steinberg::int32 meterHistoryPos = 0;
+		Steinberg::int32 meterHistorySize = 0;
 	};
 
 
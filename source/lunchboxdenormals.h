@@ -0,0 +1,87 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2023 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+//------------------------------------------------------------------------
+//  Denormals
+//  The recursive filters ring down into the denormal range after every
+//  sound, and denormal arithmetic takes tens to hundreds of cycles per
+//  operation on x86. Instead of testing samples inside the loops, the
+//  kernels run with the FPU flushing them to zero: FTZ (results) and DAZ
+//  (operands) in MXCSR on x86 / x64, FZ in FPCR / FPSCR on ARM. Only values
+//  below 2.2e-308 are touched, far below anything audible.
+//
+//  ScopedDenormals sets the flags for its lifetime and puts the previous
+//  ones back, so the host's (or another plug-in's) FPU state is left as
+//  it was. This is independent of LUNCHBOX_NO_SIMD: the scalar build does
+//  its double math in the same SSE2 / NEON registers.
+//------------------------------------------------------------------------
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LUNCHBOX_DENORMALS_MXCSR 1
+#include <xmmintrin.h>
+#elif defined(_M_ARM64)
+#define LUNCHBOX_DENORMALS_FPCR 1
+#include <intrin.h>
+#elif defined(__aarch64__) || (defined(__arm__) && defined(__ARM_FP))
+#define LUNCHBOX_DENORMALS_FPCR 1
+#endif
+
+namespace yg331 {
+
+	class ScopedDenormals
+	{
+	public:
+		ScopedDenormals()
+		{
+			previous = get();
+			set(previous | kFlushBits);
+		}
+
+		~ScopedDenormals()
+		{
+			set(previous);
+		}
+
+		ScopedDenormals(const ScopedDenormals&) = delete;
+		ScopedDenormals& operator=(const ScopedDenormals&) = delete;
+
+	private:
+#if defined(LUNCHBOX_DENORMALS_MXCSR)
+		static const unsigned int kFlushBits = 0x8040;	// FTZ (bit 15) | DAZ (bit 6)
+		typedef unsigned int Register;
+
+		static Register get() { return _mm_getcsr(); }
+		static void set(Register r) { _mm_setcsr(r); }
+#elif defined(LUNCHBOX_DENORMALS_FPCR) && defined(_M_ARM64)
+		static const unsigned long long kFlushBits = 1ull << 24;	// FZ
+		typedef unsigned long long Register;
+
+		static Register get() { return _ReadStatusReg(ARM64_FPCR); }
+		static void set(Register r) { _WriteStatusReg(ARM64_FPCR, (__int64)r); }
+#elif defined(LUNCHBOX_DENORMALS_FPCR) && defined(__aarch64__)
+		static const unsigned long long kFlushBits = 1ull << 24;	// FZ
+		typedef unsigned long long Register;
+
+		static Register get() { Register r; __asm__ __volatile__("mrs %0, fpcr" : "=r"(r)); return r; }
+		static void set(Register r) { __asm__ __volatile__("msr fpcr, %0" : : "r"(r)); }
+#elif defined(LUNCHBOX_DENORMALS_FPCR)
+		static const unsigned int kFlushBits = 1u << 24;	// FZ
+		typedef unsigned int Register;
+
+		static Register get() { Register r; __asm__ __volatile__("vmrs %0, fpscr" : "=r"(r)); return r; }
+		static void set(Register r) { __asm__ __volatile__("vmsr fpscr, %0" : : "r"(r)); }
+#else
+		static const unsigned int kFlushBits = 0;	// no known control register, nothing to do
+		typedef unsigned int Register;
+
+		static Register get() { return 0; }
+		static void set(Register) {}
+#endif
+
+		Register previous;
+	};
+
+	//------------------------------------------------------------------------
+} // namespace yg331
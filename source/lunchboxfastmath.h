@@ -0,0 +1,71 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2023 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "lunchboxsimd.h"
+
+#include <math.h>
+
+namespace yg331 {
+
+	//------------------------------------------------------------------------
+	//  Fast sin / cos for the kernels
+	//  Channel9 only takes sines of arguments within +-pi/2 (it clips before
+	//  its sines), and the Gate's 1 - cos(level) is 2 sin(level / 2)^2 with
+	//  levels that hardly ever leave 0..pi. So one odd polynomial covers
+	//  both without range reduction:
+	//  sin(x) = x * P(x^2), P of degree 5, minimax for the relative error on
+	//  |x| <= pi/2. It is plain + and *, all lanes at once in the vector unit.
+	//
+	//  Max error against libm (airwindows_500_lunchbox_bench --accuracy):
+	//  sinFast 2.7e-11 on |x| <= pi/2 (-211 dB), versineFast 1.1e-10 on |x| <= pi (-199 dB).
+	//  versineFast hands frames with a lane beyond pi to libm. The precise
+	//  mode of the processor keeps the libm calls.
+	//------------------------------------------------------------------------
+	const double kFastPi = 3.14159265358979323846;	// M_PI needs _USE_MATH_DEFINES on MSVC
+
+	/** sin(x) for |x| <= pi/2 */
+	template <typename V>
+	inline V sinFast(const V& x)
+	{
+		const V x2 = x * x;
+		V p = -2.3889779149171687e-08;
+		p = p * x2 + 2.7525304445300214e-06;
+		p = p * x2 - 0.00019840861927153383;
+		p = p * x2 + 0.008333330980798801;
+		p = p * x2 - 0.166666666170189;
+		p = p * x2 + 0.9999999999830195;
+		return x * p;
+	}
+
+	/** 1 - cos(x) as 2 sin(x / 2)^2, exactly 0 at 0; the polynomial for
+	    |x| <= pi, libm for anything else */
+	template <typename V>
+	inline V versineFast(const V& x)
+	{
+		if (any(absLanes(x) > kFastPi))
+			return 1.0 - perLane(x, [](double y) { return cos(y); });
+		V s = sinFast(x * 0.5);
+		return 2.0 * s * s;
+	}
+
+	/** sin(x) by libm or, |x| <= pi/2, by sinFast */
+	template <typename V>
+	inline V sinLanes(const V& x, bool precise)
+	{
+		if (precise) return perLane(x, [](double y) { return sin(y); });
+		return sinFast(x);
+	}
+
+	/** 1 - cos(x) by libm or, |x| <= pi, by versineFast */
+	template <typename V>
+	inline V versineLanes(const V& x, bool precise)
+	{
+		if (precise) return 1.0 - perLane(x, [](double y) { return cos(y); });
+		return versineFast(x);
+	}
+
+	//------------------------------------------------------------------------
+} // namespace yg331
@@ -0,0 +1,914 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2023 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "lunchboxsimd.h"
+#include "lunchboxfastmath.h"
+
+#include <math.h>
+
+namespace yg331 {
+
+	//------------------------------------------------------------------------
+	//  Per-sample kernels of the channel strip
+	//  The state of every stage is kept per lane, V is one of the lane types
+	//  of lunchboxsimd.h (Double2 : a channel pair, Double1 : a lone channel,
+	//  wider types : LunchboxBank). The coefficients are
+	//  worked out once per block by lunchboxProcessor::prepareX().
+	//  Branches on the signal become select(), both sides are computed with
+	//  the same operations as the scalar code, so the output does not change.
+	//------------------------------------------------------------------------
+
+	//------------------------------------------------------------------------
+	// Channel9 + add Highpass
+	//------------------------------------------------------------------------
+	struct Channel9Coeffs
+	{
+		double localiirAmount;
+		double localthreshold;
+		double biquadA[7];	// cutoff / Fs, Q, a0, a1, a2, b1, b2
+		double biquadB[7];
+		bool precise;		// libm sin, otherwise sinFast
+	};
+
+	template <typename V>
+	struct Channel9State
+	{
+		V iirSampleA = 0.0;
+		V iirSampleB = 0.0;
+		V lastSampleA = 0.0;
+		V lastSampleB = 0.0;
+		V lastSampleC = 0.0;
+		V biquadA[4] = { 0.0, 0.0, 0.0, 0.0 };	// x1, x2, y1, y2
+		V biquadB[4] = { 0.0, 0.0, 0.0, 0.0 };
+		bool flip = false;
+	};
+
+	template <typename V>
+	inline void tickBiquadChannel9(V* state, const double* biquad, V& inputSample)
+	{
+		V tempSample = biquad[2] * inputSample + biquad[3] * state[0] + biquad[4] * state[1] - biquad[5] * state[2] - biquad[6] * state[3];
+		state[1] = state[0]; state[0] = inputSample; inputSample = tempSample;
+		state[3] = state[2]; state[2] = inputSample; //DF1
+	}
+
+	template <typename V>
+	inline void tickChannel9(Channel9State<V>& s, V& inputSample, const Channel9Coeffs& c, double drive)
+	{
+		double localiirAmount = c.localiirAmount;
+		double localthreshold = c.localthreshold;
+
+		double density = drive; //0-2, originally at "* 2.0"
+		double phattity = density - 1.0;
+		density = (density > 1.0) ? 1.0 : density; //max out at full wet for Spiral aspect
+		phattity = (phattity < 0.0) ? 0.0 : phattity; //
+		double nonLin = 5.0 - density; //number is smaller for more intense, larger for more subtle
+
+		if (c.biquadA[0] < 0.49999)
+			tickBiquadChannel9(s.biquadA, c.biquadA, inputSample);
+
+		V dielectricScale = absLanes(2.0 - ((inputSample + nonLin) / nonLin));
+
+		V& iirSample = s.flip ? s.iirSampleA : s.iirSampleB;
+		iirSample = (iirSample * (1.0 - (localiirAmount * dielectricScale))) + (inputSample * localiirAmount * dielectricScale);
+		inputSample = inputSample - iirSample;
+		//highpass section
+		V drySample = inputSample;
+
+		inputSample = select(inputSample > 1.0, 1.0, inputSample);
+		inputSample = select(inputSample < -1.0, -1.0, inputSample);
+		V phatSample = sinLanes(inputSample * 1.57079633, c.precise);
+		inputSample = inputSample * 1.2533141373155;
+		//clip to 1.2533141373155 to reach maximum output, or 1.57079633 for pure sine 'phat' version
+
+		V absSample = absLanes(inputSample);
+		V distSample = sinLanes(inputSample * absSample, c.precise) / select(absSample == 0.0, 1.0, absSample);
+
+		inputSample = distSample; //purest form is full Spiral
+		if (density < 1.0) inputSample = (drySample * (1 - density)) + (distSample * density); //fade Spiral aspect
+		if (phattity > 0.0) inputSample = (inputSample * (1 - phattity)) + (phatSample * phattity); //apply original Density on top
+
+		V clamp = (s.lastSampleB - s.lastSampleC) * 0.381966011250105;
+		clamp = clamp - (s.lastSampleA - s.lastSampleB) * 0.6180339887498948482045;
+		clamp = clamp + (inputSample - s.lastSampleA); //regular slew clamping added
+
+		s.lastSampleC = s.lastSampleB;
+		s.lastSampleB = s.lastSampleA;
+		s.lastSampleA = inputSample; //now our output relates off lastSampleB
+
+		inputSample = select(clamp > localthreshold, s.lastSampleB + localthreshold, inputSample);
+		inputSample = select(-clamp > localthreshold, s.lastSampleB - localthreshold, inputSample);
+
+		s.lastSampleA = (s.lastSampleA * 0.381966011250105) + (inputSample * 0.6180339887498948482045); //split the difference between raw and smoothed for buffer
+
+		s.flip = !s.flip;
+
+		if (c.biquadB[0] < 0.49999)
+			tickBiquadChannel9(s.biquadB, c.biquadB, inputSample);
+	}
+
+	//------------------------------------------------------------------------
+	// EQ
+	//------------------------------------------------------------------------
+	struct EQCoeffs
+	{
+		static const int kBands = 6;	// 10, 40, 160, 640, 2.5k, 20k
+
+		// filters, from setCoeffs (and setPeakCoeffs for 1.2kHz)
+		double z_10[3], p_10[3];
+		double z_40[3], p_40[3];
+		double z_160[3], p_160[3];
+		double z_640[3], p_640[3];
+		double z_1k2[3], p_1k2[3];
+		double z_2k5[3], p_2k5[3];
+		double z_20k[3], p_20k[3];
+
+		// band gains, from prepareEQ
+		double g_10, pg_10;
+		double g_40, pg_40;
+		double g_160, pg_160;
+		double g_640, pg_640;
+		double g_2k5, pg_2k5;
+		double g_20k, pg_20k;
+		double globalGain;
+
+		// the parallel bands as they run, from prepareEQ: g * pg * globalGain
+		// folded into the numerators, the dry part of every band summed in direct
+		double b0[kBands], b1[kBands], b2[kBands], a1[kBands], a2[kBands];
+		double direct;
+	};
+
+	//  Six bands in parallel on the same input, then the 1.2kHz peak in series.
+	//  Every band is a transposed direct form II biquad (the first order 2.5k
+	//  and 20k ones with b2 = a2 = 0), two state values and no shuffling.
+	//  The bands are summed in pairs, 10 + 160 + 2.5k and 40 + 640 + 20k, the
+	//  order the band lanes of a mono channel add up in, so a mono channel and
+	//  either side of a pair come out the same.
+	template <typename V>
+	struct EQState
+	{
+		V s1[EQCoeffs::kBands], s2[EQCoeffs::kBands];
+		V s1_1k2 = 0.0, s2_1k2 = 0.0;
+
+		EQState()
+		{
+			for (int b = 0; b < EQCoeffs::kBands; b++) s1[b] = s2[b] = 0.0;
+		}
+	};
+
+	/** y = b0 x + s1, s1 = b1 x - a1 y + s2, s2 = b2 x - a2 y */
+	template <typename V, typename C>
+	inline V tickBiquadTDF2(V& s1, V& s2, const C& b0, const C& b1, const C& b2, const C& a1, const C& a2, const V& x)
+	{
+		V y = x * b0 + s1;
+		s1 = x * b1 - y * a1 + s2;
+		s2 = x * b2 - y * a2;
+		return y;
+	}
+
+	template <typename V>
+	inline void tickEQ(EQState<V>& s, V& inputSample, const EQCoeffs& c)
+	{
+		V y[EQCoeffs::kBands];
+		for (int b = 0; b < EQCoeffs::kBands; b++)
+			y[b] = tickBiquadTDF2(s.s1[b], s.s2[b], c.b0[b], c.b1[b], c.b2[b], c.a1[b], c.a2[b], inputSample);
+
+		V dataOut = ((y[0] + y[2]) + y[4]) + ((y[1] + y[3]) + y[5]);
+		dataOut = dataOut + inputSample * c.direct;
+
+		// 1200Hz
+		inputSample = tickBiquadTDF2(s.s1_1k2, s.s2_1k2, c.z_1k2[0], c.z_1k2[1], c.z_1k2[2], c.p_1k2[1], c.p_1k2[2], dataOut);
+	}
+
+	/** A mono channel has no second channel to fill the lanes with, so its
+	    bands take them instead: 10 | 40, 160 | 640, 2.5k | 20k */
+	template <>
+	struct EQState<Double1>
+	{
+		Double2 s1[EQCoeffs::kBands / 2], s2[EQCoeffs::kBands / 2];
+		Double1 s1_1k2 = 0.0, s2_1k2 = 0.0;
+
+		EQState()
+		{
+			for (int k = 0; k < EQCoeffs::kBands / 2; k++) s1[k] = s2[k] = 0.0;
+		}
+	};
+
+	inline void tickEQ(EQState<Double1>& s, Double1& inputSample, const EQCoeffs& c)
+	{
+		const Double2 x = inputSample.v;
+		Double2 sum = 0.0;
+		for (int k = 0; k < EQCoeffs::kBands / 2; k++)
+		{
+			Double2 y = tickBiquadTDF2(s.s1[k], s.s2[k], Double2::load(c.b0 + 2 * k), Double2::load(c.b1 + 2 * k),
+				Double2::load(c.b2 + 2 * k), Double2::load(c.a1 + 2 * k), Double2::load(c.a2 + 2 * k), x);
+			sum = (k == 0) ? y : sum + y;
+		}
+
+		Double1 dataOut = sum.lane(0) + sum.lane(1);
+		dataOut = dataOut + inputSample * c.direct;
+
+		// 1200Hz
+		inputSample = tickBiquadTDF2(s.s1_1k2, s.s2_1k2, c.z_1k2[0], c.z_1k2[1], c.z_1k2[2], c.p_1k2[1], c.p_1k2[2], dataOut);
+	}
+
+	//------------------------------------------------------------------------
+	// DeBess
+	//------------------------------------------------------------------------
+	struct DeBessCoeffs
+	{
+		double intensity;
+		double sharpness;
+		double speed;
+		double depth;
+		double iirAmount;
+		double linkAmount;	// Linked: one-pole of the envelopes that pick the louder channel
+		bool monitoring;
+	};
+
+	static const double kDeBessLinkMs = 10.0;
+
+	//  The detector keeps the last N = (int)sharpness inputs s[1..N] and their
+	//  slews of slews m[2..N-1], and multiplies the N - 1 terms
+	//  |m[x] - m[x + 1]| (those below 1) into sense. Every sample the
+	//  whole of s and m moves on by one and only m[1], m[2] and the ends of
+	//  the product are new, so instead of shifting them: s and m are rings,
+	//  and the middle of the product, x = 2 .. N - 2, is a window sliding
+	//  over one factor per sample. That window is the product of the suffix
+	//  of the previous block of N - 3 factors and the running prefix of the
+	//  current one, the suffix worked out once per block: O(1) per sample,
+	//  whatever the Sharpness.
+	//  Slots past N keep the values they had when N was last larger (m[N]
+	//  is read but never written), as the shifting arrays did.
+	template <typename V>
+	struct DeBessState
+	{
+		static const int kMaxLength = 40;	// sharpness * 40
+		static const int kRing = 64;
+
+		V sRing[kRing];		// s[k] at lag k - 1, k <= N
+		V mRing[kRing];		// m[x] at lag x - 2, 2 <= x < N
+		int sPos = 0;
+		int mPos = 0;
+		V m1 = 0.0;
+		V sFrozen[kMaxLength + 1];	// s[k], k > N
+		V mFrozen[kMaxLength + 1];	// m[x], x >= N
+
+		V suffix[kMaxLength + 1];	// suffix products of the last full block
+		V prefix = 1.0;				// and the product of the current one so far
+		int count = 0;
+		double sharpness = -1.0;	// what the above are laid out for
+
+		V ratioA = 1.0;
+		V ratioB = 1.0;
+		V iirSampleA = 0.0;
+		V iirSampleB = 0.0;
+		bool flip = false;
+		V level = 0.0;		// Linked: the envelope of each channel
+
+		DeBessState()
+		{
+			for (int x = 0; x < kRing; x++) sRing[x] = mRing[x] = 0.0;
+			for (int x = 0; x <= kMaxLength; x++) sFrozen[x] = mFrozen[x] = suffix[x] = 0.0;
+		}
+
+		const V& sAt(int lag) const { return sRing[(sPos + lag) & (kRing - 1)]; }
+		const V& mAt(int lag) const { return mRing[(mPos + lag) & (kRing - 1)]; }
+		void pushS(const V& x) { sPos = (sPos - 1) & (kRing - 1); sRing[sPos] = x; }
+		void pushM(const V& x) { mPos = (mPos - 1) & (kRing - 1); mRing[mPos] = x; }
+	};
+
+	/** |a - b| * sharpness^2 where it is below 1, else 1 */
+	template <typename V>
+	inline V slewFactor(const V& a, const V& b, double sharpness)
+	{
+		V mult = absLanes(a - b) * sharpness * sharpness;
+		return select(mult < 1.0, mult, 1.0);
+	}
+
+	/** The suffix products of the last N - 3 factors, the newest last */
+	template <typename V>
+	inline void startDeBessBlock(DeBessState<V>& st)
+	{
+		const int window = (int)st.sharpness - 3;
+		if (window <= 0) return;
+		st.suffix[window] = 1.0;
+		for (int i = window - 1; i >= 0; i--)
+			st.suffix[i] = slewFactor(st.mAt(window - 1 - i), st.mAt(window - i), st.sharpness) * st.suffix[i + 1];
+		st.prefix = 1.0;
+		st.count = 0;
+	}
+
+	/** Sharpness moved: freeze and thaw slots the way the shifting arrays
+	    would have, then start the product over */
+	template <typename V>
+	inline void setDeBessSharpness(DeBessState<V>& st, double sharpness)
+	{
+		const int kMaxLength = DeBessState<V>::kMaxLength;
+		const int length = (int)st.sharpness;
+		for (int k = 1; k <= length && k <= kMaxLength; k++) st.sFrozen[k] = st.sAt(k - 1);
+		for (int x = 2; x < length && x <= kMaxLength; x++) st.mFrozen[x] = st.mAt(x - 2);
+
+		// the next sample works m[3 .. N - 1] out from s[2 .. N], thawed ones too
+		const V* s = st.sFrozen;
+		const int newLength = (int)sharpness;
+		st.sPos = st.mPos = 0;
+		for (int k = 1; k <= kMaxLength; k++) st.sRing[k - 1] = s[k];
+		for (int x = 2; x <= kMaxLength; x++)
+			st.mRing[x - 2] = (x < newLength) ? (s[x] - s[x + 1]) * ((s[x - 1] - s[x]) / 1.3) : st.mFrozen[x];
+
+		st.sharpness = sharpness;
+		startDeBessBlock(st);
+	}
+
+	/** The detector: slews of slews of inputSample, shaped into the target ratio */
+	template <typename V>
+	inline V senseDeBess(DeBessState<V>& st, const V& inputSample, const DeBessCoeffs& c)
+	{
+		double intensity = c.intensity;
+		double sharpness = c.sharpness;
+
+		if (sharpness != st.sharpness) setDeBessSharpness(st, sharpness);
+		const int length = (int)sharpness;
+		const int window = length - 3;
+
+		st.pushS(inputSample); //building up a set of slews
+		V slew = st.sAt(0) - st.sAt(1);
+		st.m1 = slew * (slew / 1.3);
+		if (length >= 3) {
+			st.pushM((st.sAt(1) - st.sAt(2)) * (slew / 1.3)); //building up a set of slews of slews
+			if (window > 0) {
+				st.prefix = st.prefix * slewFactor(st.mAt(0), st.mAt(1), sharpness);
+				if (++st.count == window) startDeBessBlock(st);
+			}
+		}
+
+		//sense is slews of slews times each other
+		V m2 = (length >= 3) ? st.mAt(0) : st.mFrozen[2];
+		V sense = absLanes(st.m1 - m2) * sharpness * sharpness;
+		if (length >= 3) sense = sense * slewFactor(st.mAt(length - 3), st.mFrozen[length], sharpness);
+		if (window > 0) sense = sense * (st.suffix[st.count] * st.prefix);
+		sense = sense * slewFactor(st.m1, m2, sharpness);
+		sense = 1.0 + (intensity * intensity * sense);
+		sense = select(sense > intensity, intensity, sense);
+		return sense;
+	}
+
+	/** tmp : lowest gain of the block so far, for the meter */
+	template <typename V>
+	inline void meterGain(const V& inputSample, const V& drySample, double& tmp)
+	{
+		double out[V::kLanes], dry[V::kLanes];
+		inputSample.store(out);
+		drySample.store(dry);
+		for (int i = 0; i < V::kLanes; i++)
+			if (tmp > (out[i] / dry[i])) tmp = (out[i] / dry[i]);
+	}
+
+	/** tmp : lowest gain of the block so far, for the meter */
+	template <typename V>
+	inline void tickDeBess(DeBessState<V>& st, V& inputSample, const DeBessCoeffs& c, double& tmp)
+	{
+		double speed = c.speed;
+		double depth = c.depth;
+		double iirAmount = c.iirAmount;
+
+		V drySample = inputSample;
+
+		V sense = senseDeBess(st, inputSample, c);
+
+		V& iirSample = st.flip ? st.iirSampleA : st.iirSampleB;
+		V& ratio = st.flip ? st.ratioA : st.ratioB;
+		iirSample = (iirSample * (1 - iirAmount)) + (inputSample * iirAmount);
+		ratio = (ratio * (1.0 - speed)) + (sense * speed);
+		ratio = select(ratio > depth, depth, ratio);
+		// both halves test ratioA, as the original does
+		inputSample = select(st.ratioA > 1.0, iirSample + ((inputSample - iirSample) / ratio), inputSample);
+		st.flip = !st.flip;
+
+		meterGain(inputSample, drySample, tmp);
+
+		if (c.monitoring) inputSample = drySample - inputSample;
+		//sense monitoring
+	}
+
+	/** A pair on one shared ratio in link.ratioA/B, and one detector in link.
+	    Linked: the detector hears the channel whose envelope is louder; the
+	    envelopes move slowly, so it seldom changes over, and a change only
+	    costs a few samples of slews across the two channels. Mono sum: it
+	    hears (L + R) / 2. The lowpass iirSample stays per channel. */
+	inline void tickDeBessLinked(DeBessState<Double2>& st, DeBessState<Double1>& link, Double2& inputSample,
+		const DeBessCoeffs& c, bool monoSum, double& tmp)
+	{
+		double speed = c.speed;
+		double depth = c.depth;
+		double iirAmount = c.iirAmount;
+
+		Double2 drySample = inputSample;
+
+		double x[2];
+		inputSample.store(x);
+		Double1 detect;
+		if (monoSum) detect = (x[0] + x[1]) * 0.5;
+		else {
+			double l[2];
+			st.level = st.level + (absLanes(inputSample) - st.level) * c.linkAmount;
+			st.level.store(l);
+			detect = (l[0] >= l[1]) ? x[0] : x[1];
+		}
+		Double1 sense = senseDeBess(link, detect, c);
+
+		Double2& iirSample = st.flip ? st.iirSampleA : st.iirSampleB;
+		Double1& ratio = st.flip ? link.ratioA : link.ratioB;
+		iirSample = (iirSample * (1 - iirAmount)) + (inputSample * iirAmount);
+		ratio = (ratio * (1.0 - speed)) + (sense * speed);
+		ratio = select(ratio > depth, depth, ratio);
+		if (link.ratioA.v > 1.0) inputSample = iirSample + ((inputSample - iirSample) / Double2(ratio.v));
+		st.flip = !st.flip;
+
+		meterGain(inputSample, drySample, tmp);
+
+		if (c.monitoring) inputSample = drySample - inputSample;
+	}
+
+	/** Lane i of v, for the states a pair hands between its own detectors
+	    and the one of Linked and Mono Sum */
+	template <typename V>
+	inline double laneOf(const V& v, int i)
+	{
+		double x[V::kLanes];
+		v.store(x);
+		return x[i];
+	}
+
+	/** to takes the detector and ratio of lane i of from, in every lane: when
+	    Detect changes, the detectors that take over carry on from where the
+	    ones that ran left off */
+	template <typename To, typename From>
+	inline void seedDeBess(DeBessState<To>& to, const DeBessState<From>& from, int i)
+	{
+		for (int x = 0; x < DeBessState<To>::kRing; x++) {
+			to.sRing[x] = laneOf(from.sRing[x], i);
+			to.mRing[x] = laneOf(from.mRing[x], i);
+		}
+		for (int x = 0; x <= DeBessState<To>::kMaxLength; x++) {
+			to.sFrozen[x] = laneOf(from.sFrozen[x], i);
+			to.mFrozen[x] = laneOf(from.mFrozen[x], i);
+			to.suffix[x] = laneOf(from.suffix[x], i);
+		}
+		to.sPos = from.sPos;
+		to.mPos = from.mPos;
+		to.m1 = laneOf(from.m1, i);
+		to.prefix = laneOf(from.prefix, i);
+		to.count = from.count;
+		to.sharpness = from.sharpness;
+		to.ratioA = laneOf(from.ratioA, i);
+		to.ratioB = laneOf(from.ratioB, i);
+	}
+
+	/** The channel of a pair DeBess works hardest on */
+	inline int louderDeBess(const DeBessState<Double2>& st)
+	{
+		return (laneOf(st.ratioA, 1) + laneOf(st.ratioB, 1) > laneOf(st.ratioA, 0) + laneOf(st.ratioB, 0)) ? 1 : 0;
+	}
+
+	//------------------------------------------------------------------------
+	// MeowMu
+	//------------------------------------------------------------------------
+	struct CompCoeffs
+	{
+		double threshold;
+		double release;
+		double fastest;
+		double speedStep;	// what muSpeed falls by per update, 1 at kTimingReferenceRate
+		double attackScale;	// 2 (Attack) or 5 there, times the rate
+		bool attack;
+		double inputGain;	// +12 dB into the gain computer
+		double outputGain;	// and -12 dB after it
+		bool efficient;		// the block engine below instead of the µ state machine
+		double attackCoeff;	// efficient: one-pole per sample towards a lower gain
+		double releaseCoeff;	// and back up
+	};
+
+	template <typename V>
+	struct CompState
+	{
+		V muVary = 1.0;
+		V muAttack = 0.0;
+		V muNewSpeed = 0.0;
+		V muSpeedA = 10000.0;
+		V muSpeedB = 10000.0;
+		V muCoefficientA = 1.0;
+		V muCoefficientB = 1.0;
+		V previous = 0.0;
+		bool flip = false;
+		V gain = 1.0;	// efficient: the followed gain
+	};
+
+	/** to takes lane i of from in every lane, as seedDeBess */
+	template <typename To, typename From>
+	inline void seedComp(CompState<To>& to, const CompState<From>& from, int i)
+	{
+		to.muVary = laneOf(from.muVary, i);
+		to.muAttack = laneOf(from.muAttack, i);
+		to.muNewSpeed = laneOf(from.muNewSpeed, i);
+		to.muSpeedA = laneOf(from.muSpeedA, i);
+		to.muSpeedB = laneOf(from.muSpeedB, i);
+		to.muCoefficientA = laneOf(from.muCoefficientA, i);
+		to.muCoefficientB = laneOf(from.muCoefficientB, i);
+		to.previous = laneOf(from.previous, i);
+		to.flip = from.flip;
+		to.gain = laneOf(from.gain, i);
+	}
+
+	/** The channel of a pair MeowMu holds down harder, the one Linked follows */
+	inline int louderComp(const CompState<Double2>& s, bool efficient)
+	{
+		if (efficient) return (laneOf(s.gain, 1) < laneOf(s.gain, 0)) ? 1 : 0;
+		return (laneOf(s.muCoefficientA, 1) + laneOf(s.muCoefficientB, 1) < laneOf(s.muCoefficientA, 0) + laneOf(s.muCoefficientB, 0)) ? 1 : 0;
+	}
+
+	/** The gain computer: moves the µ state on by one (+12 dB) detector sample
+	    and returns the gain for it */
+	template <typename V>
+	inline V gainComp(CompState<V>& s, const V& inputSample, const CompCoeffs& c)
+	{
+		double threshold = c.threshold;
+		double release = c.release;
+		double fastest = c.fastest;
+
+		V squaredSample = select(absLanes(inputSample) > absLanes(s.previous), s.previous * s.previous, inputSample * inputSample);
+		s.previous = inputSample;
+		// inputSample *= muMakeupGain;
+
+		//adjust coefficients
+		V& muSpeed = s.flip ? s.muSpeedA : s.muSpeedB;
+		V& muCoefficient = s.flip ? s.muCoefficientA : s.muCoefficientB;
+
+		V coefficient = muCoefficient * ((muSpeed * muSpeed) - 1.0);
+		coefficient = coefficient + 1.0;
+		coefficient = coefficient / (muSpeed * muSpeed);
+
+		typename V::Mask over = absLanes(squaredSample) > threshold;
+		if (any(over))
+		{
+			V muVary = threshold / absLanes(squaredSample);
+			V muAttack = sqrtLanes(absLanes(muSpeed)) * c.attackScale;
+			V attacked = muCoefficient * (muAttack - 1.0);
+			attacked = attacked + select(muVary < threshold, threshold, muVary);
+			attacked = attacked / muAttack;
+
+			coefficient = select(over, attacked, coefficient);
+			s.muVary = select(over, muVary, s.muVary);
+			s.muAttack = select(over, muAttack, s.muAttack);
+		}
+		muCoefficient = coefficient;
+
+		s.muNewSpeed = muSpeed * (muSpeed - c.speedStep);
+		s.muNewSpeed = s.muNewSpeed + absLanes(squaredSample * release) + fastest;
+		muSpeed = s.muNewSpeed / muSpeed;
+		//got coefficients, adjusted speeds
+
+		coefficient = (muCoefficient + muCoefficient * muCoefficient) / 2.0;
+		s.flip = !s.flip;
+		return coefficient;
+	}
+
+	/** the Comp meter, which also reads unity while any lane is untouched */
+	template <typename V>
+	inline void meterComp(const V& inputSample, const V& drySample, double& tmp)
+	{
+		meterGain(inputSample, drySample, tmp);
+		double out[V::kLanes], dry[V::kLanes];
+		inputSample.store(out);
+		drySample.store(dry);
+		for (int i = 0; i < V::kLanes; i++)
+			if (out[i] == dry[i]) tmp = 1.0;
+	}
+
+	/** key : what the gain computer listens to, the sample itself or the
+	    sidechain's; tmp : lowest gain of the block so far, for the meter */
+	template <typename V>
+	inline void tickComp(CompState<V>& s, V& inputSample, V key, const CompCoeffs& c, double& tmp)
+	{
+		// µ µ µ µ µ µ µ µ µ µ µ µ is the kitten song o/~
+
+		V drySample = inputSample;
+
+		inputSample = inputSample * c.inputGain;
+
+		V coefficient = gainComp(s, key * c.inputGain, c);
+		inputSample = inputSample * coefficient;
+		//applied compression with vari-vari-µ-µ-µ-µ-µ-µ-is-the-kitten-song o/~
+		//applied gain correction to control output level- tends to constrain sound rather than inflate it
+
+		inputSample = inputSample * c.outputGain;
+
+		meterComp(inputSample, drySample, tmp);
+	}
+
+	template <typename V>
+	inline void tickComp(CompState<V>& s, V& inputSample, const CompCoeffs& c, double& tmp)
+	{
+		tickComp(s, inputSample, inputSample, c, tmp);
+	}
+
+	/** A pair on one gain computer in link, half the detector work. Linked:
+	    driven by the louder channel of key; mono sum: by (L + R) / 2. */
+	inline void tickCompLinked(CompState<Double1>& link, Double2& inputSample, Double2 key, const CompCoeffs& c, bool monoSum, double& tmp)
+	{
+		Double2 drySample = inputSample;
+
+		inputSample = inputSample * c.inputGain;
+
+		double x[2];
+		(key * c.inputGain).store(x);
+		Double1 detect = monoSum ? (x[0] + x[1]) * 0.5 : ((fabs(x[0]) > fabs(x[1])) ? x[0] : x[1]);
+
+		Double1 coefficient = gainComp(link, detect, c);
+		inputSample = inputSample * Double2(coefficient.v);
+
+		inputSample = inputSample * c.outputGain;
+
+		meterComp(inputSample, drySample, tmp);
+	}
+
+	//------------------------------------------------------------------------
+	// MeowMu, efficient
+	// The same threshold, gain staging and output curve on a plain feed
+	// forward follower, run over a block in three passes: the target gains
+	// from the squared +12 dB detector, the follower on them, and the gains
+	// multiplied in. The first and last passes carry no state, so every
+	// sample is the same few vector instructions; only the follower goes
+	// sample after sample, without branches, square roots or divisions.
+	// Against the vintage engine:
+	// - one gain per lane instead of two interleaved ones (muCoefficientA / B)
+	// - attack and release are fixed one-poles set by Speed and Attack, at
+	//   the times the vintage engine has on quiet material; that one slows
+	//   both down the louder it is driven, so it lets go of loud passages
+	//   more slowly than this one
+	// - the detector is the sample itself, not the smaller of it and the one
+	//   before, so single-sample peaks are caught
+	// - the meter shows the lowest gain of the block
+	//------------------------------------------------------------------------
+	static constexpr int kCompBlock = 64;	// frames per pass, on the stack
+
+	/** The gain that takes the squared detector sample down to the threshold,
+	    unity below it and no lower than the threshold itself */
+	template <typename V>
+	inline V targetComp(const V& detect, const CompCoeffs& c)
+	{
+		V squaredSample = detect * detect;
+		V target = c.threshold / select(squaredSample > c.threshold, squaredSample, V(c.threshold));
+		return select(target < c.threshold, V(c.threshold), target);
+	}
+
+	/** One sample of the follower, the gain for it with the vintage curve:
+	    towards the target at the attack rate while the detector is over the
+	    threshold, back towards unity at the release rate below it */
+	template <typename V>
+	inline V followComp(CompState<V>& s, const V& target, const CompCoeffs& c)
+	{
+		V coefficient = select(target < 1.0, V(c.attackCoeff), V(c.releaseCoeff));
+		s.gain = s.gain + (target - s.gain) * coefficient;
+		return (s.gain + s.gain * s.gain) * 0.5;
+	}
+
+	/** The follower over a block of targets, into gains in place;
+	    tmp : lowest gain so far, for the meter */
+	template <typename V>
+	inline void followCompBlock(CompState<V>& s, V* gain, int frames, const CompCoeffs& c, double& tmp)
+	{
+		V lowest = 1.0;
+		for (int n = 0; n < frames; n++)
+		{
+			gain[n] = followComp(s, gain[n], c);
+			lowest = select(gain[n] < lowest, gain[n], lowest);
+		}
+		double lanes[V::kLanes];
+		lowest.store(lanes);
+		for (int i = 0; i < V::kLanes; i++)
+			if (tmp > lanes[i]) tmp = lanes[i];
+	}
+
+	/** A block of frames, compressed in place, every lane on its own gain;
+	    key : the frames the detector listens to, block itself or the sidechain's */
+	template <typename V>
+	inline void compEfficientBlock(CompState<V>& s, V* block, const V* key, int frames, const CompCoeffs& c, double& tmp)
+	{
+		V gain[kCompBlock];
+		for (int n = 0; n < frames; n++)
+			gain[n] = targetComp(key[n] * c.inputGain, c);
+
+		followCompBlock(s, gain, frames, c, tmp);
+
+		for (int n = 0; n < frames; n++)
+			block[n] = ((block[n] * c.inputGain) * gain[n]) * c.outputGain;
+	}
+
+	/** A pair on one gain in link, as tickCompLinked: the louder channel,
+	    or (L + R) / 2 for monoSum */
+	inline void compEfficientLinkedBlock(CompState<Double1>& link, Double2* block, const Double2* key, int frames, const CompCoeffs& c, bool monoSum, double& tmp)
+	{
+		Double1 gain[kCompBlock];
+		for (int n = 0; n < frames; n++)
+		{
+			double x[2];
+			(key[n] * c.inputGain).store(x);
+			Double1 detect = monoSum ? (x[0] + x[1]) * 0.5 : ((fabs(x[0]) > fabs(x[1])) ? x[0] : x[1]);
+			gain[n] = targetComp(detect, c);
+		}
+
+		followCompBlock(link, gain, frames, c, tmp);
+
+		for (int n = 0; n < frames; n++)
+			block[n] = ((block[n] * c.inputGain) * Double2(gain[n].v)) * c.outputGain;
+	}
+
+	/** The same sample by sample, for callers that run the stages fused per
+	    sample (LunchboxBank); every sample comes out as from the block passes */
+	template <typename V>
+	inline void tickCompEfficient(CompState<V>& s, V& inputSample, const CompCoeffs& c, double& tmp)
+	{
+		V coefficient = followComp(s, targetComp(inputSample * c.inputGain, c), c);
+		inputSample = ((inputSample * c.inputGain) * coefficient) * c.outputGain;
+
+		double lanes[V::kLanes];
+		coefficient.store(lanes);
+		for (int i = 0; i < V::kLanes; i++)
+			if (tmp > lanes[i]) tmp = lanes[i];
+	}
+
+	//------------------------------------------------------------------------
+	// Mid/side: M = (L + R) / 2 and S = (L - R) / 2 in the two lanes
+	//------------------------------------------------------------------------
+	inline Double2 encodeMidSide(const Double2& x)
+	{
+		double v[2];
+		x.store(v);
+		return Double2((v[0] + v[1]) * 0.5, (v[0] - v[1]) * 0.5);
+	}
+
+	inline Double2 decodeMidSide(const Double2& x)
+	{
+		double v[2];
+		x.store(v);
+		return Double2(v[0] + v[1], v[0] - v[1]);
+	}
+
+	//------------------------------------------------------------------------
+	// Gate
+	//------------------------------------------------------------------------
+	struct GateCoeffs
+	{
+		double onthreshold;
+		double offthreshold;
+		double release;
+		double absmax;
+		double step;	// zeroCross per sample: 1 at kTimingReferenceRate, less oversampled or faster
+		bool precise;	// libm cos, otherwise versineFast
+	};
+
+	template <typename V>
+	struct GateState
+	{
+		V wasNegative = 0.0;	// 1.0 : last sample was not above zero
+		V zeroCross = 0.0;		// samples at the base rate
+		V gateroller = 0.0;
+		V gate = 0.0;
+	};
+
+	/** key : what opens and closes the gate, the sample itself or the
+	    sidechain's; the gate and its rectifier shape inputSample */
+	template <typename V>
+	inline void tickGate(GateState<V>& s, V& inputSample, V key, const GateCoeffs& c)
+	{
+		typedef typename V::Mask Mask;
+
+		//begin Gate
+		Mask positive = key > 0.0;
+		V restart = (double)(int)(c.absmax * 0.3);
+		s.zeroCross = select(positive, select(s.wasNegative == 1.0, restart, s.zeroCross), s.zeroCross + c.step);
+		s.wasNegative = select(positive, 0.0, 1.0);
+		s.zeroCross = select(s.zeroCross > c.absmax, (double)(int)c.absmax, s.zeroCross);
+
+		// while silent the gate only triggers above onthreshold, once open
+		// the signal must clear offthreshold, otherwise it closes anyway
+		V level = absLanes(key);
+		Mask silent = s.gate == 0.0;
+		Mask trigger = (silent & (level > c.onthreshold)) | ((!silent) & (level > c.offthreshold));
+		V released = s.gateroller - c.release;
+		V triggered = select(silent,
+			select(s.gateroller == 0.0, s.zeroCross, released),
+			select(s.gateroller < s.zeroCross, s.zeroCross, released));
+		s.gateroller = select(trigger, triggered, released);
+		s.gateroller = select(s.gateroller < 0.0, 0.0, s.gateroller);
+
+		Mask closing = s.gateroller < 1.0;
+		if (any(closing))
+		{
+			V gate = s.gateroller;
+			V bridgerectifier = versineLanes(absLanes(inputSample), c.precise);
+			V gated = select(inputSample > 0.0,
+				(inputSample * gate) + (bridgerectifier * (1.0 - gate)),
+				(inputSample * gate) - (bridgerectifier * (1.0 - gate)));
+			gated = select(gate == 0.0, 0.0, gated);
+			inputSample = select(closing, gated, inputSample);
+			s.gate = select(closing, gate, 1.0);
+		}
+		else s.gate = 1.0;
+		//end Gate
+	}
+
+	template <typename V>
+	inline void tickGate(GateState<V>& s, V& inputSample, const GateCoeffs& c)
+	{
+		tickGate(s, inputSample, inputSample, c);
+	}
+
+	//------------------------------------------------------------------------
+	// Sidechain
+	//------------------------------------------------------------------------
+	/** The key on its way to MeowMu or the Gate, held back by what the
+	    oversamplers and the limiter before the stage hold back its input */
+	template <typename V>
+	struct KeyDelayState
+	{
+		static const int kLength = 512;	// power of two above 8x linear phase and Safe at 192 kHz
+
+		V data[kLength];
+		int pos = 0;
+
+		KeyDelayState() { for (int i = 0; i < kLength; i++) data[i] = 0.0; }
+	};
+
+	/** key from delay samples ago, key itself for 0 */
+	template <typename V>
+	inline V tickKeyDelay(KeyDelayState<V>& s, const V& key, int delay)
+	{
+		s.data[s.pos] = key;
+		V delayed = s.data[(s.pos - delay) & (KeyDelayState<V>::kLength - 1)];
+		s.pos = (s.pos + 1) & (KeyDelayState<V>::kLength - 1);
+		return delayed;
+	}
+
+	//------------------------------------------------------------------------
+	// Inflator
+	//------------------------------------------------------------------------
+	struct InflatorCoeffs
+	{
+		double curveA;
+		double curveB;
+		double curveC;
+		double curveD;
+		bool safe;	// clip the input to the curve's range; the limiter after it keeps the output down
+	};
+
+	template <typename V>
+	inline V clipInflator(const V& inputSample)
+	{
+		return select(inputSample > 1.0, 1.0, select(inputSample < -1.0, -1.0, inputSample));
+	}
+
+	template <typename V>
+	inline void tickInflator(V& inputSample, const InflatorCoeffs& c, double wet)
+	{
+		V drySample = inputSample;
+
+		if (c.safe) inputSample = clipInflator(inputSample);
+
+		V sign = select(inputSample > 0.0, 1.0, -1.0);
+
+		V s1 = absLanes(inputSample);
+		V s2 = s1 * s1;
+		V s3 = s2 * s1;
+		V s4 = s2 * s2;
+
+		V shaped = (c.curveA * s1) + (c.curveB * s2) + (c.curveC * s3) - (c.curveD * (s2 - (2.0 * s3) + s4));
+		shaped = select(s1 > 1.0, (2.0 * s1) - s2, shaped);
+		shaped = select(s1 >= 2.0, 0.0, shaped);
+
+		inputSample = shaped * sign;
+
+		inputSample = (drySample * (1.0 - wet)) + (inputSample * wet);
+	}
+
+	//------------------------------------------------------------------------
+	// Input
+	//------------------------------------------------------------------------
+	/** peak, squares : per lane largest magnitude and sum of squares for the
+	    meters; denormals are the FPU's business (ScopedDenormals), not the
+	    kernels' */
+	template <typename V>
+	inline void tickInput(V& inputSample, double gain, V& peak, V& squares)
+	{
+		inputSample = inputSample * gain;
+		V magnitude = absLanes(inputSample);
+		peak = select(magnitude > peak, magnitude, peak);
+		squares = squares + inputSample * inputSample;
+	}
+
+	//------------------------------------------------------------------------
+} // namespace yg331
@@ -0,0 +1,154 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2023 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "lunchboxsimd.h"
+#include "lunchboxmeter.h"
+#include "lunchboxtiming.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace yg331 {
+
+	//------------------------------------------------------------------------
+	//  Limiter
+	//  A lookahead brickwall on the true peak, after the Inflator (Safe).
+	//  The detector is the BS.1770 4x interpolation of the meters, so peaks
+	//  between the samples count too. Every sample asks for the gain that
+	//  takes its peak to the ceiling; the smallest of those over the last
+	//  lookahead + 1 samples is held, released by a one-pole, and averaged
+	//  over lookahead samples into a ramp. The audio is delayed so that the
+	//  ramp has fully arrived when the peak comes out.
+	//  The window is a running maximum over blocks of its own length: the
+	//  suffix maxima of the previous block, worked out once per block, and
+	//  the prefix maximum of the current one - O(1) per sample, branch free,
+	//  so every lane of V runs its own window in the same instructions.
+	//------------------------------------------------------------------------
+	static const double kLimiterCeilingDb = -1.0;		// dBTP
+	static const double kLimiterLookaheadMs = 1.5;
+	static const double kLimiterReleaseMs = 60.0;
+	static constexpr int kLimiterMaxLookahead = 384;	// 2 ms at 192 kHz
+
+	// the detector's newest estimate lies between the samples
+	// kTruePeakTaps / 2 and kTruePeakTaps / 2 - 1 back
+	static constexpr int kLimiterDetectorDelay = kTruePeakTaps / 2 - 1;
+
+	/** Lookahead in samples at the host rate */
+	inline int getLimiterLookahead(double sampleRate)
+	{
+		return std::min(std::max((int)ceil(msToSamples(kLimiterLookaheadMs, sampleRate)), 1), kLimiterMaxLookahead);
+	}
+
+	/** What the limiter delays the signal by */
+	inline int getLimiterLatency(double sampleRate)
+	{
+		return getLimiterLookahead(sampleRate) + kLimiterDetectorDelay;
+	}
+
+	struct LimiterCoeffs
+	{
+		int lookahead;
+		double ceiling;		// linear
+		double release;		// one-pole coefficient per sample
+		bool linked;		// a pair shares the gain of its louder channel
+	};
+
+	template <typename V>
+	struct LimiterState
+	{
+		static const int kDelay = 512;	// power of two above kLimiterMaxLookahead + kLimiterDetectorDelay
+
+		TruePeakState<V> detector;
+		V delay[kDelay];
+		int delayPos = 0;
+
+		V block[kLimiterMaxLookahead + 1];		// peaks of the current block
+		V suffix[kLimiterMaxLookahead + 2];		// suffix maxima of the previous one
+		V prefix = 0.0;
+		int count = 0;
+
+		V ramp[kLimiterMaxLookahead];	// 1 - the held and released gains, the last lookahead
+		V rampSum = 0.0;
+		int rampPos = 0;
+		V gain = 1.0;
+
+		int lookahead = 0;	// what the above are laid out for
+		double rampScale = 1.0;
+
+		LimiterState() { reset(0); }
+		void reset(int newLookahead)
+		{
+			detector.reset();
+			for (int i = 0; i < kDelay; i++) delay[i] = 0.0;
+			delayPos = 0;
+			for (int i = 0; i <= kLimiterMaxLookahead; i++) block[i] = 0.0;
+			for (int i = 0; i <= kLimiterMaxLookahead + 1; i++) suffix[i] = 0.0;
+			prefix = 0.0;
+			count = 0;
+			for (int i = 0; i < kLimiterMaxLookahead; i++) ramp[i] = 0.0;
+			rampSum = 0.0;
+			rampPos = 0;
+			gain = 1.0;
+			lookahead = newLookahead;
+			rampScale = (newLookahead > 0) ? 1.0 / newLookahead : 1.0;
+		}
+	};
+
+	/** The window is done: its peaks become the suffix maxima, and the ramp
+	    sum is added up afresh so it cannot drift */
+	template <typename V>
+	inline void startLimiterBlock(LimiterState<V>& s)
+	{
+		const int window = s.lookahead + 1;
+		s.suffix[window] = 0.0;
+		for (int i = window - 1; i >= 0; i--)
+			s.suffix[i] = select(s.block[i] > s.suffix[i + 1], s.block[i], s.suffix[i + 1]);
+		s.prefix = 0.0;
+		s.count = 0;
+
+		V sum = 0.0;
+		for (int i = 0; i < s.lookahead; i++) sum = sum + s.ramp[i];
+		s.rampSum = sum;
+	}
+
+	template <typename V>
+	inline void tickLimiter(LimiterState<V>& s, V& inputSample, const LimiterCoeffs& c)
+	{
+		if (c.lookahead != s.lookahead) s.reset(c.lookahead);
+		if (s.count == s.lookahead + 1) startLimiterBlock(s);
+
+		// the true peak around the sample kLimiterDetectorDelay back, and that
+		// sample itself
+		V peak = tickTruePeak(s.detector, inputSample);
+		V sample = absLanes(s.detector.history[s.detector.pos + kLimiterDetectorDelay]);
+		peak = select(sample > peak, sample, peak);
+		if (c.linked) peak = V(maxOfLanes(peak));
+
+		// the largest over the window
+		s.block[s.count++] = peak;
+		s.prefix = select(peak > s.prefix, peak, s.prefix);
+		V windowPeak = s.suffix[s.count];
+		windowPeak = select(s.prefix > windowPeak, s.prefix, windowPeak);
+
+		// its gain, straight down, released back up
+		V target = select(windowPeak > c.ceiling, c.ceiling / windowPeak, 1.0);
+		s.gain = select(target < s.gain, target, s.gain + (target - s.gain) * c.release);
+
+		// ramped over the lookahead, as reductions: without any the sum is
+		// exactly 0 and the signal comes through untouched
+		V reduction = 1.0 - s.gain;
+		s.rampSum = s.rampSum + reduction - s.ramp[s.rampPos];
+		s.ramp[s.rampPos] = reduction;
+		s.rampPos = (s.rampPos + 1 == s.lookahead) ? 0 : s.rampPos + 1;
+
+		const int latency = s.lookahead + kLimiterDetectorDelay;
+		s.delay[s.delayPos] = inputSample;
+		inputSample = s.delay[(s.delayPos - latency) & (LimiterState<V>::kDelay - 1)] * (1.0 - s.rampSum * s.rampScale);
+		s.delayPos = (s.delayPos + 1) & (LimiterState<V>::kDelay - 1);
+	}
+
+	//------------------------------------------------------------------------
+} // namespace yg331
@@ -0,0 +1,276 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2023 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "lunchboxkernels.h"
+#include "lunchboxmeter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace yg331 {
+
+	//------------------------------------------------------------------------
+	//  Loudness
+	//  ITU-R BS.1770-4 / EBU R128: the output is K-weighted (a high shelf,
+	//  then a high pass) and its mean square summed over the channels, each
+	//  with weight 1.0. Momentary loudness is the last 400 ms of that,
+	//  short-term the last 3 s; both move in steps of kLoudnessStepFrames
+	//  meter frames (100 ms). Integrated loudness gates the 400 ms blocks
+	//  of every step at -70 LUFS and then 10 LU below their mean, loudness
+	//  range (EBU Tech 3342) the short-term values at -70 LUFS and 20 LU
+	//  below, and spans their 10th to 95th percentile. Both keep their
+	//  values in histograms of 0.1 LU, so the meter takes the same memory
+	//  and time however long it runs.
+	//------------------------------------------------------------------------
+
+	/** The two K-weighting biquads for one sample rate, in tickBiquadTDF2 form */
+	struct KWeightCoeffs
+	{
+		double b0[2], b1[2], b2[2], a1[2], a2[2];
+
+		void prepare(double sampleRate)
+		{
+			// stage 1: high shelf, +4 dB above ~1.5 kHz
+			double K = tan(kFastPi * 1681.974450955533 / sampleRate);
+			double Q = 0.7071752369554196;
+			double Vh = pow(10.0, 3.999843853973347 / 20.0);
+			double Vb = pow(Vh, 0.4996667741545416);
+			double a0 = 1.0 + K / Q + K * K;
+			b0[0] = (Vh + Vb * K / Q + K * K) / a0;
+			b1[0] = 2.0 * (K * K - Vh) / a0;
+			b2[0] = (Vh - Vb * K / Q + K * K) / a0;
+			a1[0] = 2.0 * (K * K - 1.0) / a0;
+			a2[0] = (1.0 - K / Q + K * K) / a0;
+
+			// stage 2: RLB high pass at 38 Hz
+			K = tan(kFastPi * 38.13547087602444 / sampleRate);
+			Q = 0.5003270373238773;
+			a0 = 1.0 + K / Q + K * K;
+			b0[1] = 1.0;
+			b1[1] = -2.0;
+			b2[1] = 1.0;
+			a1[1] = 2.0 * (K * K - 1.0) / a0;
+			a2[1] = (1.0 - K / Q + K * K) / a0;
+		}
+	};
+
+	template <typename V>
+	struct KWeightState
+	{
+		V s1[2], s2[2];
+
+		KWeightState() { reset(); }
+		void reset() { s1[0] = s2[0] = s1[1] = s2[1] = 0.0; }
+	};
+
+	/** Both channels of a group share the coefficients, one lane each */
+	template <typename V>
+	inline V tickKWeight(KWeightState<V>& s, const KWeightCoeffs& c, const V& inputSample)
+	{
+		V y = tickBiquadTDF2(s.s1[0], s.s2[0], c.b0[0], c.b1[0], c.b2[0], c.a1[0], c.a2[0], inputSample);
+		return tickBiquadTDF2(s.s1[1], s.s2[1], c.b0[1], c.b1[1], c.b2[1], c.a1[1], c.a2[1], y);
+	}
+
+	//------------------------------------------------------------------------
+	static const int kLoudnessStepFrames = 10;	// meter frames of kMeterFrameMs, 100 ms
+	static const int kMomentarySteps = 4;		// 400 ms
+	static const int kShortTermSteps = 30;		// 3 s
+
+	static const double kLoudnessAbsoluteGate = -70.0;	// LUFS
+	static const double kLoudnessSilence = -150.0;		// what digital silence reads
+
+	/** LUFS of the channel sum of mean squares */
+	inline double loudnessOf(double energy)
+	{
+		return (energy > 0.0) ? std::max(-0.691 + 10.0 * log10(energy), kLoudnessSilence) : kLoudnessSilence;
+	}
+
+	//------------------------------------------------------------------------
+	/** Counts and energy sums of loudness values from kLoudnessAbsoluteGate up, in 0.1 LU bins */
+	class LoudnessHistogram
+	{
+	public:
+		static const int kBins = 1000;	// -70 .. +30 LUFS
+
+		void reset()
+		{
+			std::fill(counts, counts + kBins, 0u);
+			std::fill(energies, energies + kBins, 0.0);
+			total = 0;
+			totalEnergy = 0.0;
+		}
+
+		/** Below the absolute gate nothing is kept */
+		void add(double energy)
+		{
+			double loudness = loudnessOf(energy);
+			if (loudness < kLoudnessAbsoluteGate)
+				return;
+			int bin = binOf(loudness);
+			counts[bin]++;
+			energies[bin] += energy;
+			total++;
+			totalEnergy += energy;
+		}
+
+		/** First bin of what passes the gate relativeGate LU below the mean energy,
+		    kBins if there is nothing */
+		int gateBin(double relativeGate) const
+		{
+			if (total == 0)
+				return kBins;
+			return binOf(std::max(loudnessOf(totalEnergy / total) + relativeGate, kLoudnessAbsoluteGate));
+		}
+
+		/** Mean energy from bin on */
+		double meanEnergy(int bin) const
+		{
+			Steinberg::uint64 count = 0;
+			double energy = 0.0;
+			for (int i = bin; i < kBins; i++) {
+				count += counts[i];
+				energy += energies[i];
+			}
+			return (count > 0) ? energy / count : 0.0;
+		}
+
+		/** Loudness at which fraction of the values from bin on lie below, the
+		    centre of its bin */
+		double percentile(int bin, double fraction) const
+		{
+			Steinberg::uint64 count = 0;
+			for (int i = bin; i < kBins; i++) count += counts[i];
+			if (count == 0)
+				return kLoudnessSilence;
+			Steinberg::uint64 rank = (Steinberg::uint64)(fraction * (count - 1) + 0.5);
+			Steinberg::uint64 seen = 0;
+			int i = bin;
+			for (; i < kBins - 1; i++) {
+				seen += counts[i];
+				if (seen > rank) break;
+			}
+			return kLoudnessAbsoluteGate + (i + 0.5) * 0.1;
+		}
+
+	private:
+		static int binOf(double loudness)
+		{
+			return std::min(std::max((int)((loudness - kLoudnessAbsoluteGate) * 10.0), 0), kBins - 1);
+		}
+
+		Steinberg::uint32 counts[kBins];
+		double energies[kBins];
+		Steinberg::uint64 total;
+		double totalEnergy;
+	};
+
+	//------------------------------------------------------------------------
+	/** Momentary, short-term, integrated loudness and loudness range of the
+	    output, fed one meter frame at a time on the audio thread */
+	class LoudnessMeter
+	{
+	public:
+		LoudnessMeter() { reset(); }
+
+		void reset()
+		{
+			for (int i = 0; i < kShortTermSteps; i++) {
+				stepSquares[i] = 0.0;
+				stepLengths[i] = 0;
+			}
+			stepPos = 0;
+			steps = 0;
+			framesInStep = 0;
+			blocks.reset();
+			shortTerms.reset();
+			momentary = shortTerm = integrated = kLoudnessSilence;
+			range = 0.0;
+			maxMomentary = maxShortTerm = kLoudnessSilence;
+			truePeak = 0.0;
+		}
+
+		/** One meter frame: its K-weighted squares summed over the channels, its
+		    length and true peak */
+		void addFrame(double weightedSquares, Steinberg::int32 frames, double frameTruePeak)
+		{
+			stepSquares[stepPos] += weightedSquares;
+			stepLengths[stepPos] += frames;
+			truePeak = std::max(truePeak, frameTruePeak);
+			if (++framesInStep < kLoudnessStepFrames)
+				return;
+
+			framesInStep = 0;
+			steps++;
+			stepPos = (stepPos + 1) % kShortTermSteps;
+
+			double energy = energyOf(kMomentarySteps);
+			momentary = loudnessOf(energy);
+			if (steps >= kMomentarySteps) {
+				blocks.add(energy);
+				maxMomentary = std::max(maxMomentary, momentary);
+				integrated = loudnessOf(blocks.meanEnergy(blocks.gateBin(-10.0)));
+			}
+
+			energy = energyOf(kShortTermSteps);
+			shortTerm = loudnessOf(energy);
+			if (steps >= kShortTermSteps) {
+				shortTerms.add(energy);
+				maxShortTerm = std::max(maxShortTerm, shortTerm);
+				int bin = shortTerms.gateBin(-20.0);
+				range = std::max(shortTerms.percentile(bin, 0.95) - shortTerms.percentile(bin, 0.10), 0.0);
+			}
+
+			stepSquares[stepPos] = 0.0;
+			stepLengths[stepPos] = 0;
+		}
+
+		/** The current values into the loudness fields of a frame */
+		void fillFrame(MeterFrame& frame) const
+		{
+			frame.momentary = (float)momentary;
+			frame.shortTerm = (float)shortTerm;
+			frame.integrated = (float)integrated;
+			frame.loudnessRange = (float)range;
+		}
+
+		double getMomentary() const { return momentary; }
+		double getShortTerm() const { return shortTerm; }
+		double getIntegrated() const { return integrated; }		// LUFS
+		double getLoudnessRange() const { return range; }		// LU
+		double getMaxMomentary() const { return maxMomentary; }
+		double getMaxShortTerm() const { return maxShortTerm; }
+		double getTruePeak() const { return truePeak; }			// linear, since the reset
+
+	private:
+		/** Mean square of the last count finished steps */
+		double energyOf(int count) const
+		{
+			double squares = 0.0;
+			Steinberg::int64 length = 0;
+			for (int i = 1; i <= count; i++) {
+				int step = (stepPos + kShortTermSteps - i) % kShortTermSteps;
+				squares += stepSquares[step];
+				length += stepLengths[step];
+			}
+			return (length > 0) ? squares / length : 0.0;
+		}
+
+		double stepSquares[kShortTermSteps];
+		Steinberg::int64 stepLengths[kShortTermSteps];
+		int stepPos;
+		Steinberg::int64 steps;
+		int framesInStep;
+
+		LoudnessHistogram blocks;		// 400 ms blocks, for the integrated loudness
+		LoudnessHistogram shortTerms;	// 3 s values, for the loudness range
+
+		double momentary, shortTerm, integrated, range;
+		double maxMomentary, maxShortTerm;
+		double truePeak;
+	};
+
+	//------------------------------------------------------------------------
+} // namespace yg331
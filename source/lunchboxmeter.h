@@ -0,0 +1,202 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2023 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "pluginterfaces/base/ftypes.h"
+#include "lunchboxsimd.h"
+
+#include <atomic>
+
+namespace yg331 {
+
+	//------------------------------------------------------------------------
+	//  Metering
+	//  The audio thread sums its meters over fixed periods of kMeterFrameMs
+	//  and pushes every period as a MeterFrame into a MeterRing. Nothing on
+	//  that side allocates or waits: when the ring is full the frame is
+	//  dropped. The controller asks for the frames from its UI timer
+	//  (kMeterRequestMessage) and the processor answers on the same thread
+	//  with everything the ring holds (kMeterFramesMessage), so how often the
+	//  editor refreshes depends neither on the host's block size nor on its
+	//  audio thread.
+	//------------------------------------------------------------------------
+	static const double kMeterFrameMs = 10.0;
+	static const Steinberg::uint32 kMeterRequestMs = 30;	// UI timer of the controller
+
+	static const char* const kMeterRequestMessage = "LunchboxMeterRequest";
+	static const char* const kMeterFramesMessage = "LunchboxMeterFrames";
+	static const char* const kMeterFramesAttribute = "Frames";	// binary, MeterFrame[]
+
+	/** One period of the meters, all as linear gains */
+	struct MeterFrame
+	{
+		float inPeak;			// largest |sample| after the Input gain
+		float inRms;			// RMS after the Input gain, mean power of the channels
+		float outPeak;			// largest |sample| of the output
+		float outRms;
+		float outTruePeak;		// largest |sample| of the output 4x oversampled
+		float deEssGain;		// lowest DeBess gain, 1 : no reduction
+		float compGain;			// lowest MeowMu gain
+		float momentary;		// LUFS, see lunchboxloudness.h
+		float shortTerm;		// LUFS
+		float integrated;		// LUFS, since the processor was activated
+		float loudnessRange;	// LU
+		Steinberg::int32 frames;	// length of the period in samples
+	};
+
+	//------------------------------------------------------------------------
+	/** Ring of T for one producer thread and one consumer thread, lock free.
+	    kCapacity is a power of two; the positions only ever grow and wrap
+	    around as unsigned integers. */
+	template <typename T, Steinberg::uint32 kCapacity>
+	class SpscRing
+	{
+		static_assert((kCapacity & (kCapacity - 1)) == 0, "kCapacity must be a power of two");
+
+	public:
+		/** Producer: false if the ring is full, the item is not kept */
+		bool push(const T& item)
+		{
+			Steinberg::uint32 write = writePos.load(std::memory_order_relaxed);
+			if (write - readPos.load(std::memory_order_acquire) == kCapacity) return false;
+			items[write & (kCapacity - 1)] = item;
+			writePos.store(write + 1, std::memory_order_release);
+			return true;
+		}
+
+		/** Consumer: false if the ring is empty */
+		bool pop(T& item)
+		{
+			Steinberg::uint32 read = readPos.load(std::memory_order_relaxed);
+			if (read == writePos.load(std::memory_order_acquire)) return false;
+			item = items[read & (kCapacity - 1)];
+			readPos.store(read + 1, std::memory_order_release);
+			return true;
+		}
+
+	private:
+		T items[kCapacity];
+		alignas(64) std::atomic<Steinberg::uint32> writePos{ 0 };	// own cache lines, the two
+		alignas(64) std::atomic<Steinberg::uint32> readPos{ 0 };	// threads do not share them
+	};
+
+	// 1.28 s of frames, the editor asks every kMeterRequestMs
+	static const Steinberg::uint32 kMeterRingFrames = 128;
+	typedef SpscRing<MeterFrame, kMeterRingFrames> MeterRing;
+
+	//------------------------------------------------------------------------
+	/** What the stages add up over the current MeterFrame */
+	struct MeterSums
+	{
+		double inPeak = 0.0;
+		double inSquares = 0.0;		// of all channels
+		double outPeak = 0.0;
+		double outSquares = 0.0;
+		double outTruePeak = 0.0;
+		double outWeighted = 0.0;	// K-weighted squares of all channels
+		double deEssGain = 1.0;
+		double compGain = 1.0;
+		Steinberg::int32 frames = 0;
+
+		/** The frame for numChannels channels, and starts the next one. The
+		    loudness fields are left to LoudnessMeter::fillFrame. */
+		MeterFrame finish(Steinberg::int32 numChannels)
+		{
+			double count = (frames > 0 && numChannels > 0) ? (double)frames * numChannels : 1.0;
+			MeterFrame frame;
+			frame.inPeak = (float)inPeak;
+			frame.inRms = (float)sqrt(inSquares / count);
+			frame.outPeak = (float)outPeak;
+			frame.outRms = (float)sqrt(outSquares / count);
+			frame.outTruePeak = (float)outTruePeak;
+			frame.deEssGain = (float)deEssGain;
+			frame.compGain = (float)compGain;
+			frame.momentary = frame.shortTerm = frame.integrated = frame.loudnessRange = 0.f;
+			frame.frames = frames;
+			*this = MeterSums();
+			return frame;
+		}
+	};
+
+	//------------------------------------------------------------------------
+	// True peak
+	// ITU-R BS.1770-4 Annex 2: 4x oversampling by a 48 tap FIR, run as four
+	// phases of 12 taps on the last 12 input samples, the true peak is the
+	// largest magnitude of the four. Phases 3 and 2 are phases 0 and 1
+	// backwards, so each pair is run once on the sums and differences of
+	// the mirrored samples: with y = E + O and y' = E - O, the larger
+	// magnitude is |E| + |O|. The history is kept twice in a row, so the
+	// taps always read 12 values in one piece.
+	//------------------------------------------------------------------------
+	static const int kTruePeakTaps = 12;
+	static constexpr double kTruePeakPhases[4][kTruePeakTaps] = {
+		{ 0.0017089843750,  0.0109863281250, -0.0196533203125,  0.0332031250000, -0.0594482421875,  0.1373291015625,
+		  0.9721679687500, -0.1022949218750,  0.0476074218750, -0.0266113281250,  0.0148925781250, -0.0083007812500 },
+		{-0.0291748046875,  0.0292968750000, -0.0517578125000,  0.0891113281250, -0.1665039062500,  0.4650878906250,
+		  0.7797851562500, -0.2003173828125,  0.1015625000000, -0.0582275390625,  0.0330810546875, -0.0189208984375 },
+		{-0.0189208984375,  0.0330810546875, -0.0582275390625,  0.1015625000000, -0.2003173828125,  0.7797851562500,
+		  0.4650878906250, -0.1665039062500,  0.0891113281250, -0.0517578125000,  0.0292968750000, -0.0291748046875 },
+		{-0.0083007812500,  0.0148925781250, -0.0266113281250,  0.0476074218750, -0.1022949218750,  0.9721679687500,
+		  0.1373291015625, -0.0594482421875,  0.0332031250000, -0.0196533203125,  0.0109863281250,  0.0017089843750 }
+	};
+
+	/** Halves of the mirrored sums and differences of phase p (0 or 1), tap k < 6 */
+	inline constexpr double truePeakEven(int p, int k)
+	{
+		return 0.5 * (kTruePeakPhases[p][k] + kTruePeakPhases[p][kTruePeakTaps - 1 - k]);
+	}
+	inline constexpr double truePeakOdd(int p, int k)
+	{
+		return 0.5 * (kTruePeakPhases[p][k] - kTruePeakPhases[p][kTruePeakTaps - 1 - k]);
+	}
+
+	template <typename V>
+	struct TruePeakState
+	{
+		V history[2 * kTruePeakTaps];
+		int pos = 0;
+
+		TruePeakState() { reset(); }
+		void reset()
+		{
+			for (int i = 0; i < 2 * kTruePeakTaps; i++) history[i] = 0.0;
+			pos = 0;
+		}
+	};
+
+	/** Feeds one sample, returns the largest magnitude of the four phases after it */
+	template <typename V>
+	inline V tickTruePeak(TruePeakState<V>& s, const V& inputSample)
+	{
+		s.pos = (s.pos == 0) ? kTruePeakTaps - 1 : s.pos - 1;
+		s.history[s.pos] = s.history[s.pos + kTruePeakTaps] = inputSample;
+		const V* x = s.history + s.pos;	// x[0] : the newest
+
+		const int last = kTruePeakTaps - 1;
+		V sum = x[0] + x[last];
+		V difference = x[0] - x[last];
+		V even[2], odd[2];
+		for (int p = 0; p < 2; p++)
+		{
+			even[p] = truePeakEven(p, 0) * sum;
+			odd[p] = truePeakOdd(p, 0) * difference;
+		}
+		for (int k = 1; k < kTruePeakTaps / 2; k++)
+		{
+			sum = x[k] + x[last - k];
+			difference = x[k] - x[last - k];
+			for (int p = 0; p < 2; p++)
+			{
+				even[p] = even[p] + truePeakEven(p, k) * sum;
+				odd[p] = odd[p] + truePeakOdd(p, k) * difference;
+			}
+		}
+		V outer = absLanes(even[0]) + absLanes(odd[0]);	// phases 0 and 3
+		V inner = absLanes(even[1]) + absLanes(odd[1]);	// phases 1 and 2
+		return select(outer > inner, outer, inner);
+	}
+
+	//------------------------------------------------------------------------
+} // namespace yg331
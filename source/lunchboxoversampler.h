@@ -0,0 +1,364 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2023 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "lunchboxsimd.h"
+
+#include <math.h>
+
+namespace yg331 {
+
+	//------------------------------------------------------------------------
+	//  Oversampler
+	//  2x, 4x or 8x as a cascade of 2x half-band stages, one sample frame in
+	//  and one out at a time so it sits inside the per-sample kernels. Every
+	//  stage is polyphase: it works at the lower of its two rates, and the
+	//  filters run in the same lanes as the channels.
+	//
+	//  Linear phase: a Kaiser windowed-sinc half-band FIR, every other tap is
+	//  zero so one phase is a plain delay and the other a symmetric FIR.
+	//  Low latency: two chains of first order allpasses (polyphase IIR, the
+	//  elliptic half-band design), a few samples of delay but not linear phase.
+	//
+	//  The first stage carries the full audio band, so it is the long one;
+	//  the later stages only have to reject images far from the passband.
+	//------------------------------------------------------------------------
+	struct HalfbandFIR
+	{
+		static const int kMaxTaps = 48;
+
+		int numTaps = 0;			// odd phase taps, symmetric, numTaps / 2 distinct
+		double taps[kMaxTaps] = {};	// times 2, the gain of the zero-stuffed phase
+	};
+
+	struct HalfbandIIR
+	{
+		static const int kMaxCoefs = 12;
+
+		int numCoefs = 0;
+		double coefs[kMaxCoefs] = {};	// even index : first phase, odd : second
+	};
+
+	struct OversamplerCoeffs
+	{
+		static const int kMaxStages = 3;
+
+		int stages = 0;		// 0 : off, 1 : 2x, 2 : 4x, 3 : 8x
+		bool linearPhase = false;
+		HalfbandFIR fir[kMaxStages];
+		HalfbandIIR iir[kMaxStages];
+
+		int getFactor() const { return 1 << stages; }
+	};
+
+	//------------------------------------------------------------------------
+	// Design
+	//------------------------------------------------------------------------
+	namespace HalfbandDesign {
+
+		// M_PI is not there on MSVC without _USE_MATH_DEFINES
+		const double kPi = 3.14159265358979323846;
+
+		inline double besselI0(double x)
+		{
+			double sum = 1.0, term = 1.0;
+			for (int k = 1; k < 50 && term > sum * 1e-17; k++) {
+				term *= (x / (2.0 * k)) * (x / (2.0 * k));
+				sum += term;
+			}
+			return sum;
+		}
+
+		/** numTaps odd phase taps of a half-band lowpass, Kaiser window beta */
+		inline void fir(HalfbandFIR& f, int numTaps, double beta)
+		{
+			f.numTaps = numTaps;
+			for (int j = 0; j < numTaps; j++) {
+				int n = 2 * j - (numTaps - 1);	// odd, -(numTaps - 1) .. numTaps - 1
+				double t = (double)n / numTaps;
+				double window = besselI0(beta * sqrt(1.0 - t * t)) / besselI0(beta);
+				f.taps[j] = 2.0 * sin(kPi * n * 0.5) / (kPi * n) * window;
+			}
+			// unity gain at DC for the filtered phase
+			double sum = 0.0;
+			for (int j = 0; j < numTaps; j++) sum += f.taps[j];
+			for (int j = 0; j < numTaps; j++) f.taps[j] /= sum;
+		}
+
+		/** numCoefs allpass coefficients for the normalized transition band
+		    (at the higher rate), elliptic half-band by the Jacobi theta series */
+		inline void iir(HalfbandIIR& f, int numCoefs, double transition)
+		{
+			f.numCoefs = numCoefs;
+
+			double k = tan((1.0 - transition * 2.0) * kPi / 4.0);
+			k *= k;
+			const double kksqrt = pow(1.0 - k * k, 0.25);
+			const double e = 0.5 * (1.0 - kksqrt) / (1.0 + kksqrt);
+			const double e4 = e * e * e * e;
+			const double q = e * (1.0 + e4 * (2.0 + e4 * (15.0 + 150.0 * e4)));
+
+			const int order = numCoefs * 2 + 1;
+			for (int index = 0; index < numCoefs; index++) {
+				const int c = index + 1;
+
+				double num = 0.0, term;
+				int i = 0, sign = 1;
+				do {
+					term = pow(q, i * (i + 1)) * sin((i * 2 + 1) * c * kPi / order) * sign;
+					num += term;
+					sign = -sign;
+					i++;
+				} while (fabs(term) > 1e-100);
+
+				double den = 0.0;
+				i = 1; sign = -1;
+				do {
+					term = pow(q, i * i) * cos(i * 2 * c * kPi / order) * sign;
+					den += term;
+					sign = -sign;
+					i++;
+				} while (fabs(term) > 1e-100);
+
+				const double ww = num * pow(q, 0.25) / (den + 0.5);
+				const double wwsq = ww * ww;
+				const double x = sqrt((1.0 - wwsq * k) * (1.0 - wwsq / k)) / (1.0 + wwsq);
+				f.coefs[index] = (1.0 - x) / (1.0 + x);
+			}
+		}
+
+	} // namespace HalfbandDesign
+
+	/** The filters of all stages, once; stages and linearPhase pick from them */
+	inline void designOversampler(OversamplerCoeffs& c)
+	{
+		// passband to 20 kHz at 44.1 kHz, better than 0.01 dB flat, and 65 - 75 dB
+		// of rejection for the images and for what would fold back into it
+		HalfbandDesign::fir(c.fir[0], 48, 6.8);
+		HalfbandDesign::fir(c.fir[1], 10, 6.8);
+		HalfbandDesign::fir(c.fir[2], 10, 7.0);
+		HalfbandDesign::iir(c.iir[0], 12, 0.0232);
+		HalfbandDesign::iir(c.iir[1], 4, 0.13);
+		HalfbandDesign::iir(c.iir[2], 3, 0.19);
+	}
+
+	/** samples at the base rate an up- and downsampling round trip delays,
+	    for the IIR the group delay at low frequencies; fractional */
+	inline double getOversamplerLatency(const OversamplerCoeffs& c)
+	{
+		double latency = 0.0;
+		for (int s = 0; s < c.stages; s++)
+		{
+			double delay;	// at the higher rate of the stage, upsampling
+			if (c.linearPhase) delay = (double)(c.fir[s].numTaps - 1);
+			else {
+				double even = 0.0, odd = 1.0;
+				for (int i = 0; i < c.iir[s].numCoefs; i++) {
+					double a = c.iir[s].coefs[i];
+					if (i & 1) odd += 2.0 * (1.0 - a) / (1.0 + a);
+					else even += 2.0 * (1.0 - a) / (1.0 + a);
+				}
+				delay = 0.5 * (even + odd);
+			}
+			// the decimator keeps the second sample of each pair, one less
+			latency += (2.0 * delay - 1.0) / (double)(2 << s);
+		}
+		return latency;
+	}
+
+	/** samples at the base rate an up- and downsampling round trip rings on
+	    after its input goes silent, to -120 dB for the IIR */
+	inline double getOversamplerTail(const OversamplerCoeffs& c)
+	{
+		double tail = 0.0;
+		for (int s = 0; s < c.stages; s++)
+		{
+			double length = 0.0;	// at the lower rate of the stage, one direction
+			if (c.linearPhase) length = (double)c.fir[s].numTaps;
+			else {
+				for (int i = 0; i < c.iir[s].numCoefs; i++) {
+					double a = fabs(c.iir[s].coefs[i]);
+					if (a > 0.0) length += log(1e-6) / log(a);
+				}
+			}
+			tail += 2.0 * length / (double)(1 << s);
+		}
+		return ceil(tail);
+	}
+
+	//------------------------------------------------------------------------
+	// State
+	//------------------------------------------------------------------------
+	/** Delay line read as a contiguous window: every sample is written twice */
+	template <typename V, int kLength>
+	struct HalfbandHistory
+	{
+		V data[2 * kLength];
+		int pos = 0;
+
+		HalfbandHistory()
+		{
+			for (int i = 0; i < 2 * kLength; i++) data[i] = 0.0;
+		}
+
+		/** window()[0] is x, window()[j] the input j samples ago */
+		void push(const V& x, int length)
+		{
+			pos = (pos == 0) ? length - 1 : pos - 1;
+			data[pos] = x;
+			data[pos + length] = x;
+		}
+
+		const V* window() const { return data + pos; }
+	};
+
+	template <typename V>
+	struct HalfbandStage
+	{
+		// FIR: the filtered phase, and the plain delayed one of the decimator
+		HalfbandHistory<V, HalfbandFIR::kMaxTaps> filtered;
+		HalfbandHistory<V, HalfbandFIR::kMaxTaps> delayed;
+
+		// IIR: last input and output of every allpass
+		V x[HalfbandIIR::kMaxCoefs];
+		V y[HalfbandIIR::kMaxCoefs];
+
+		HalfbandStage()
+		{
+			for (int i = 0; i < HalfbandIIR::kMaxCoefs; i++) x[i] = y[i] = 0.0;
+		}
+	};
+
+	template <typename V>
+	struct OversamplerState
+	{
+		HalfbandStage<V> up[OversamplerCoeffs::kMaxStages];
+		HalfbandStage<V> down[OversamplerCoeffs::kMaxStages];
+	};
+
+	//------------------------------------------------------------------------
+	// One 2x stage
+	//------------------------------------------------------------------------
+	template <typename V>
+	inline V tickHalfbandFIR(const HalfbandFIR& f, const V* window)
+	{
+		const int n = f.numTaps;
+		V acc = 0.0;
+		for (int j = 0; j < n / 2; j++)
+			acc = acc + f.taps[j] * (window[j] + window[n - 1 - j]);
+		return acc;
+	}
+
+	template <typename V>
+	inline void tickAllpasses(const HalfbandIIR& f, V* x, V* y, V& first, V& second)
+	{
+		int i = 0;
+		for (; i + 1 < f.numCoefs; i += 2)
+		{
+			V t0 = (first - y[i]) * f.coefs[i] + x[i];
+			V t1 = (second - y[i + 1]) * f.coefs[i + 1] + x[i + 1];
+			x[i] = first;
+			x[i + 1] = second;
+			y[i] = t0;
+			y[i + 1] = t1;
+			first = t0;
+			second = t1;
+		}
+		if (i < f.numCoefs)
+		{
+			V t0 = (first - y[i]) * f.coefs[i] + x[i];
+			x[i] = first;
+			y[i] = t0;
+			first = t0;
+		}
+	}
+
+	/** in : one sample, out : the two at twice the rate */
+	template <typename V>
+	inline void upsample2x(HalfbandStage<V>& s, const OversamplerCoeffs& c, int stage, const V& in, V* out)
+	{
+		if (c.linearPhase)
+		{
+			const HalfbandFIR& f = c.fir[stage];
+			s.filtered.push(in, f.numTaps);
+			out[0] = tickHalfbandFIR(f, s.filtered.window());
+			out[1] = s.filtered.window()[f.numTaps / 2 - 1];
+		}
+		else
+		{
+			V first = in, second = in;
+			tickAllpasses(c.iir[stage], s.x, s.y, first, second);
+			out[0] = first;
+			out[1] = second;
+		}
+	}
+
+	/** in : two samples, returns one at half the rate */
+	template <typename V>
+	inline V downsample2x(HalfbandStage<V>& s, const OversamplerCoeffs& c, int stage, const V* in)
+	{
+		if (c.linearPhase)
+		{
+			const HalfbandFIR& f = c.fir[stage];
+			s.filtered.push(in[1], f.numTaps);
+			s.delayed.push(in[0], f.numTaps);
+			return 0.5 * (tickHalfbandFIR(f, s.filtered.window()) + s.delayed.window()[f.numTaps / 2 - 1]);
+		}
+		else
+		{
+			V first = in[1], second = in[0];
+			tickAllpasses(c.iir[stage], s.x, s.y, first, second);
+			return 0.5 * (first + second);
+		}
+	}
+
+	//------------------------------------------------------------------------
+	// The cascade
+	//------------------------------------------------------------------------
+	/** out : c.getFactor() samples */
+	template <typename V>
+	inline void upsample(OversamplerState<V>& s, const OversamplerCoeffs& c, const V& in, V* out)
+	{
+		out[0] = in;
+		for (int stage = 0; stage < c.stages; stage++)
+		{
+			// the samples at the rate of this stage, in time order
+			const int n = 1 << stage;
+			V lower[1 << (OversamplerCoeffs::kMaxStages - 1)];
+			for (int i = 0; i < n; i++) lower[i] = out[i];
+			for (int i = 0; i < n; i++)
+				upsample2x(s.up[stage], c, stage, lower[i], out + 2 * i);
+		}
+	}
+
+	/** in : c.getFactor() samples, overwritten */
+	template <typename V>
+	inline V downsample(OversamplerState<V>& s, const OversamplerCoeffs& c, V* in)
+	{
+		for (int stage = c.stages - 1; stage >= 0; stage--)
+		{
+			const int n = 1 << stage;
+			for (int i = 0; i < n; i++)
+				in[i] = downsample2x(s.down[stage], c, stage, in + 2 * i);
+		}
+		return in[0];
+	}
+
+	/** fn(sample) on every sample of one frame at the oversampled rate,
+	    just fn(inputSample) while oversampling is off */
+	template <typename V, typename Fn>
+	inline void tickOversampled(OversamplerState<V>& s, const OversamplerCoeffs& c, V& inputSample, Fn fn)
+	{
+		if (c.stages == 0) {
+			fn(inputSample);
+			return;
+		}
+		V samples[1 << OversamplerCoeffs::kMaxStages];
+		upsample(s, c, inputSample, samples);
+		for (int i = 0; i < c.getFactor(); i++) fn(samples[i]);
+		inputSample = downsample(s, c, samples);
+	}
+
+} // namespace yg331
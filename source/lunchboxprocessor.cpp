@@ -3,13 +3,18 @@
 //------------------------------------------------------------------------
 
 #include "lunchboxprocessor.h"
+#include "lunchboxdenormals.h"
 
 
 #include "base/source/fstreamer.h"
 #include "pluginterfaces/vst/ivstparameterchanges.h"
+#include "pluginterfaces/vst/ivstmessage.h"
 #include "public.sdk/source/vst/vstaudioprocessoralgo.h"
 #include "public.sdk/source/vst/vsthelpers.h"
 
+#include <algorithm>
+#include <cstring>
+
 
 using namespace Steinberg;
 
@@ -21,6 +26,8 @@ namespace yg331 {
 	{
 		//--- set the wanted controller for our processor
 		setControllerClass(klunchboxControllerUID);
+
+		designOversampler(oversampler);
 	}
 
 	//------------------------------------------------------------------------
@@ -43,6 +50,8 @@ namespace yg331 {
 		//--- create Audio IO ------
 		addAudioInput(STR16("Stereo In"), Steinberg::Vst::SpeakerArr::kStereo);
 		addAudioOutput(STR16("Stereo Out"), Steinberg::Vst::SpeakerArr::kStereo);
+		// keys MeowMu and the Gate (kParamSidechain), off until the host turns it on
+		addAudioInput(STR16("Sidechain"), Steinberg::Vst::SpeakerArr::kStereo, Vst::kAux, 0);
 
 		/* If you don't need an event bus, you can remove the next line */
 		addEventInput(STR16("Event In"), 1);
@@ -64,20 +73,269 @@ namespace yg331 {
 	{
 		//--- called when the Plug-in is enable/disable (On/Off) -----
 
-		fParamInVuPPM = 0.0;
-		fParamOutVuPPM = 0.0;
-		fParamDeEssVuPPM = 1.0;
-		fParamCompVuPPM = 1.0;
-		fParamInVuPPMOld = 0.0;
-		fParamOutVuPPMOld = 0.0;
-		fParamDeEssVuPPMOld = 1.0;
-		fParamCompVuPPMOld = 1.0;
+		if (state) {
+			snapSmoothers = true;
+			resetOversampling();
+			resetLimiter();
+
+			meterSums = MeterSums();
+			loudness.reset();
+			for (auto& group : pairs) {
+				group.truePeak.reset();
+				group.kWeight.reset();
+				group.silentFrames = 0;
+				group.sleeping = false;
+			}
+			single.truePeak.reset();
+			single.kWeight.reset();
+			single.silentFrames = 0;
+			single.sleeping = false;
+
+			// the host asks for the latency and the tail around here, for the
+			// settings it has sent while inactive
+			updateCoeffs(processSetup.sampleRate);
+		}
 		return AudioEffect::setActive(state);
 	}
 
+	//------------------------------------------------------------------------
+	void lunchboxProcessor::setParameter(Vst::ParamID id, Vst::ParamValue value)
+	{
+		switch (id) {
+		case kParamInput:   	fParamInput = (float)value;		setSmoothed(smoothInput, norm_to_gain(fParamInput));	break;
+		case kParamOutput:  	fParamOutput = (float)value;	setSmoothed(smoothOutput, norm_to_gain(fParamOutput));	break;
+		case kParamDrive:   	fParamDrive = (float)value;		setSmoothed(smoothDrive, fParamDrive);	break;
+		case kParamAir:     	setCoeffParam(fParamAir, (float)value, kDirtyEQ);	break;
+		case kParamHigh:    	setCoeffParam(fParamHigh, (float)value, kDirtyEQ);	break;
+		case kParamFocus:   	fParamFocus = (float)value;		setSmoothed(smoothFocus, fParamFocus);	break;
+		case kParamBody:    	setCoeffParam(fParamBody, (float)value, kDirtyEQ);	break;
+		case kParamLow:	    	setCoeffParam(fParamLow, (float)value, kDirtyEQ);	break;
+		case kParamIntensity:	setCoeffParam(fParamIntensity, (float)value, kDirtyDeBess);		break;
+		case kParamSharpness:	setCoeffParam(fParamSharpness, (float)value, kDirtyDeBess);		break;
+		case kParamDepth:   	setCoeffParam(fParamDepth, (float)value, kDirtyDeBess);		break;
+		case kParamComp:    	setCoeffParam(fParamComp, (float)value, kDirtyComp);	break;
+		case kParamSpeed:   	setCoeffParam(fParamSpeed, (float)value, kDirtyComp);		break;
+		case kParamGate:    	setCoeffParam(fParamGate, (float)value, kDirtyGate);	break;
+		case kParamInflate:		fParamInflate = (float)value;	setSmoothed(smoothInflate, fParamInflate);	break;
+		case kParamLowcut:  	setCoeffParam(bParamLowcut, (value > 0.5f), kDirtyEQ);	break;
+		case kParamListen:  	setCoeffParam(bParamListen, (value > 0.5f), kDirtyDeBess);	break;
+		case kParamAttack:  	setCoeffParam(bParamAttack, (value > 0.5f), kDirtyComp);	break;
+		case kParamSafe:	setCoeffParam(bParamSafe, (value > 0.5f), kDirtyInflator | kDirtyLimiter);	break;
+		case kParamBypass:  	bParamBypass = (value > 0.5f);	break;
+		case kParamDetect:	setCoeffParam(iParamDetect, std::min((int32)(value * (kNumDetectModes - 1) + 0.5), (int32)kNumDetectModes - 1), kDirtyLimiter);	break;
+		case kParamCompMode:	setCoeffParam(iParamCompMode, std::min((int32)(value * (kNumCompModes - 1) + 0.5), (int32)kNumCompModes - 1), kDirtyComp);	break;
+		case kParamSidechain:	iParamSidechain = std::min((int32)(value * (kNumSidechainModes - 1) + 0.5), (int32)kNumSidechainModes - 1);	break;
+		case kParamOversampling:	iParamOversampling = std::min((int32)(value * (kNumOversamplings - 1) + 0.5), (int32)kNumOversamplings - 1);	break;
+		case kParamOversamplingFilter:	iParamOversamplingFilter = std::min((int32)(value * (kNumOversamplingFilters - 1) + 0.5), (int32)kNumOversamplingFilters - 1);	break;
+		}
+	}
+
+	//------------------------------------------------------------------------
+	void lunchboxProcessor::setupOversampling()
+	{
+		bool linearPhase = (iParamOversamplingFilter == kFilterLinearPhase);
+		if (oversampler.stages == iParamOversampling && oversampler.linearPhase == linearPhase)
+			return;
+		oversampler.stages = iParamOversampling;	// kOversampling2x is one 2x stage, ...
+		oversampler.linearPhase = linearPhase;
+		dirtyCoeffs |= kDirtyChannel9 | kDirtyGate;	// they run at the oversampled rate
+		// what the filters hold belongs to another setting, or to long ago
+		resetOversampling();
+	}
+
+	void lunchboxProcessor::resetOversampling()
+	{
+		for (auto& group : pairs) {
+			group.overChannel9 = OversamplerState<Double2>();
+			group.overInflator = OversamplerState<Double2>();
+			group.overGate = OversamplerState<Double2>();
+		}
+		single.overChannel9 = OversamplerState<Double1>();
+		single.overInflator = OversamplerState<Double1>();
+		single.overGate = OversamplerState<Double1>();
+	}
+
+	void lunchboxProcessor::resetLimiter()
+	{
+		for (auto& group : pairs) group.limiter.reset(group.limiter.lookahead);
+		single.limiter.reset(single.limiter.lookahead);
+	}
+
+	//------------------------------------------------------------------------
+	void lunchboxProcessor::applySettings()
+	{
+		// setState may run on another thread while process() does: it only
+		// writes the parameters and raises stateChanged, what the stages hold
+		// is brought in line with them here
+		if (stateChanged.exchange(false, std::memory_order_acquire)) {
+			dirtyCoeffs = kDirtyAll;
+			resetSmoothers();
+		}
+
+		setupOversampling();
+
+		// what the limiter held belongs to long ago when Safe comes on
+		if (bParamSafe && !limiterSafe) resetLimiter();
+		limiterSafe = bParamSafe;
+
+		if (iParamDetect != linkDetect) seedLinks(linkDetect, iParamDetect);
+		linkDetect = iParamDetect;
+
+		// a stage that starts listening to the key does not hear it from long ago
+		if (iParamSidechain != keySidechain) {
+			for (auto& group : pairs) group.compKey = group.gateKey = KeyDelayState<Double2>();
+			single.compKey = single.gateKey = KeyDelayState<Double1>();
+		}
+		keySidechain = iParamSidechain;
+	}
+
+	//------------------------------------------------------------------------
+	void lunchboxProcessor::seedLinks(int32 oldDetect, int32 newDetect)
+	{
+		bool wasLinked = (oldDetect == kDetectLinked || oldDetect == kDetectMonoSum);
+		bool isLinked = (newDetect == kDetectLinked || newDetect == kDetectMonoSum);
+		if (wasLinked == isLinked) return;
+
+		for (auto& group : pairs)
+		{
+			if (isLinked) {
+				seedDeBess(group.deBessLink, group.deBess, louderDeBess(group.deBess));
+				seedComp(group.compLink, group.comp, louderComp(group.comp, iParamCompMode == kCompEfficient));
+			}
+			else {
+				seedDeBess(group.deBess, group.deBessLink, 0);
+				seedComp(group.comp, group.compLink, 0);
+			}
+		}
+	}
+
+	//------------------------------------------------------------------------
+	uint32 PLUGIN_API lunchboxProcessor::getLatencySamples()
+	{
+		// worked out with the coefficients, whenever Safe, the oversampling or
+		// the sample rate changes; what the host has now is what the
+		// controller's kLatencyRequestMessage is checked against
+		uint32 latency = latencySamples.load(std::memory_order_relaxed);
+		reportedLatency.store(latency, std::memory_order_relaxed);
+		return latency;
+	}
+
+	void lunchboxProcessor::updateLatency(Vst::Sample64 getSampleRate)
+	{
+		// Input, EQ, DeBess, MeowMu and Output work sample by sample, Channel9,
+		// Inflator and Gate delay by one up- and downsampling round trip each,
+		// the limiter by its lookahead
+		const double oversampled = getOversamplerLatency(oversampler);
+		uint32 latency = (uint32)(kOversampledStages * oversampled + 0.5);
+		if (bParamSafe) latency += getLimiterLatency(getSampleRate);
+		latencySamples.store(latency, std::memory_order_relaxed);
+
+		// the sidechain is held back as far as the signal is on its way to the
+		// stage it keys: MeowMu comes after Channel9, the Gate after Channel9,
+		// Inflator, the limiter and the upsampler of its own round trip
+		compKeyDelay = (int32)(oversampled + 0.5);
+		gateKeyDelay = (int32)(2.5 * oversampled + 0.5);
+		if (bParamSafe) gateKeyDelay += getLimiterLatency(getSampleRate);
+	}
+
+	uint32 PLUGIN_API lunchboxProcessor::getTailSamples()
+	{
+		// worked out with the coefficients, whenever a parameter or the sample rate changes
+		return tailSamples.load(std::memory_order_relaxed);
+	}
+
+	//------------------------------------------------------------------------
+	void lunchboxProcessor::resetSmoothers()
+	{
+		smoothInput.reset(norm_to_gain(fParamInput));
+		smoothOutput.reset(norm_to_gain(fParamOutput));
+		smoothDrive.reset(fParamDrive);
+		smoothFocus.reset(fParamFocus);
+		smoothInflate.reset(fParamInflate);
+	}
+
+	//------------------------------------------------------------------------
+	void lunchboxProcessor::setupChannels(int32 channels)
+	{
+		if (channels == numChannels) return;
+		numChannels = channels;
+		pairs.assign(channels / 2, ChannelGroup<Double2>());
+		single = ChannelGroup<Double1>();
+	}
+
+	//------------------------------------------------------------------------
+	// Read position in one IParamValueQueue while walking a block
+	//------------------------------------------------------------------------
+	struct QueueCursor
+	{
+		Vst::IParamValueQueue* queue;
+		Vst::ParamID id;
+		int32 numPoints;
+		int32 index;
+		int32 sampleOffset;
+		Vst::ParamValue value;
+
+		bool pending() const { return index < numPoints; }
+		void next()
+		{
+			if (++index < numPoints && queue->getPoint(index, sampleOffset, value) != kResultTrue)
+				index = numPoints;
+		}
+	};
+
+	//------------------------------------------------------------------------
+	// One frame of a channel group in and out of its lanes
+	//------------------------------------------------------------------------
+	template <typename V, typename SampleType>
+	inline V loadFrame(SampleType* const* channels, int32 n);
+
+	template <>
+	inline Double2 loadFrame<Double2, Vst::Sample32>(Vst::Sample32* const* channels, int32 n) { return Double2(channels[0][n], channels[1][n]); }
+	template <>
+	inline Double2 loadFrame<Double2, Vst::Sample64>(Vst::Sample64* const* channels, int32 n) { return Double2(channels[0][n], channels[1][n]); }
+	template <>
+	inline Double1 loadFrame<Double1, Vst::Sample32>(Vst::Sample32* const* channels, int32 n) { return Double1(channels[0][n]); }
+	template <>
+	inline Double1 loadFrame<Double1, Vst::Sample64>(Vst::Sample64* const* channels, int32 n) { return Double1(channels[0][n]); }
+
+	template <typename SampleType>
+	inline void storeFrame(const Double2& sample, SampleType* const* channels, int32 n)
+	{
+		channels[0][n] = (SampleType)sample.lane(0);
+		channels[1][n] = (SampleType)sample.lane(1);
+	}
+
+	template <typename SampleType>
+	inline void storeFrame(const Double1& sample, SampleType* const* channels, int32 n)
+	{
+		channels[0][n] = (SampleType)sample.v;
+	}
+
+	/** Rounds a frame to what a SampleType buffer would hold */
+	template <typename SampleType, typename V>
+	inline void roundTo(V& sample)
+	{
+		if (sizeof(SampleType) == sizeof(Vst::Sample32))
+			sample = roundToFloat(sample);
+	}
+
 	//------------------------------------------------------------------------
 	tresult PLUGIN_API lunchboxProcessor::process(Vst::ProcessData& data)
 	{
+		// denormals flush to zero for the whole call, the host's FPU state comes back after
+		ScopedDenormals noDenormals;
+
+		// a preset loaded since the last block, before its automation ramps from it
+		applySettings();
+
+		// Automation is applied sample accurately: the block is split at the
+		// point offsets of all queues and every stage runs on the sub-blocks.
+		// Points closer than kMinSubBlock to the previous split are applied
+		// at the next split, which bounds the per-split setup cost of the
+		// stages for very dense lanes.
+		QueueCursor cursors[kMaxParamQueues];
+		int32 numCursors = 0;
+
 		Vst::IParameterChanges* paramChanges = data.inputParameterChanges;
 		if (paramChanges)
 		{
@@ -90,358 +348,467 @@ namespace yg331 {
 					Vst::ParamValue value;
 					int32 sampleOffset;
 					int32 numPoints = paramQueue->getPointCount();
-
-					/*/*/
-					if (paramQueue->getPoint(numPoints - 1, sampleOffset, value) == kResultTrue) {
-						switch (paramQueue->getParameterId()) {
-						case kParamInput:   	fParamInput = (float)value;		break;
-						case kParamOutput:  	fParamOutput = (float)value;	break;
-						case kParamDrive:   	fParamDrive = (float)value;		break;
-						case kParamAir:     	fParamAir = (float)value;	break;
-						case kParamHigh:    	fParamHigh = (float)value;	break;
-						case kParamFocus:   	fParamFocus = (float)value;		break;
-						case kParamBody:    	fParamBody = (float)value;	break;
-						case kParamLow:	    	fParamLow = (float)value;	break;
-						case kParamIntensity:	fParamIntensity = (float)value;		break;
-						case kParamSharpness:	fParamSharpness = (float)value;		break;
-						case kParamDepth:   	fParamDepth = (float)value;		break;
-						case kParamComp:    	fParamComp = (float)value;	break;
-						case kParamSpeed:   	fParamSpeed = (float)value;		break;
-						case kParamGate:    	fParamGate = (float)value;	break;
-						case kParamInflate:		fParamInflate = (float)value;	break;
-						case kParamLowcut:  	bParamLowcut = (value > 0.5f);	break;
-						case kParamListen:  	bParamListen = (value > 0.5f);	break;
-						case kParamAttack:  	bParamAttack = (value > 0.5f);	break;
-						case kParamSafe:    	bParamSafe = (value > 0.5f);	break;
-						case kParamBypass:  	bParamBypass = (value > 0.5f);	break;
-						}
+					if (numPoints <= 0)
+						continue;
+
+					if (numCursors == kMaxParamQueues) {
+						// more queues than parameters: only honour the final value
+						if (paramQueue->getPoint(numPoints - 1, sampleOffset, value) == kResultTrue)
+							setParameter(paramQueue->getParameterId(), value);
+						continue;
 					}
+
+					QueueCursor& cursor = cursors[numCursors];
+					cursor.queue = paramQueue;
+					cursor.id = paramQueue->getParameterId();
+					cursor.numPoints = numPoints;
+					cursor.index = -1;
+					cursor.next();
+					if (cursor.pending()) numCursors++;
 				}
 			}
 		}
 
 		//--- Here you have to implement your processing
 
-
-
-		if (data.numInputs == 0 || data.numOutputs == 0) {
+		// the buses must carry the channel count set up by setBusArrangements
+		// (hosts flush parameters with empty calls, the tail follows them)
+		if (data.numInputs == 0 || data.numOutputs == 0 || data.numSamples <= 0 ||
+			data.inputs[0].numChannels != numChannels || data.outputs[0].numChannels != numChannels) {
+			for (int32 c = 0; c < numCursors; c++)
+				for (; cursors[c].pending(); cursors[c].next()) setParameter(cursors[c].id, cursors[c].value);
+			updateCoeffs(processSetup.sampleRate);
 			return kResultOk;
 		}
 
 		//---get audio buffers----------------
-		uint32 sampleFramesSize = getSampleFramesSizeInBytes(processSetup, data.numSamples);
 		void** in = getChannelBuffersPointer(processSetup, data.inputs[0]);
 		void** out = getChannelBuffersPointer(processSetup, data.outputs[0]);
 		double getSampleRate = processSetup.sampleRate;
 
 
+		// the sidechain is read where the host left it: every channel of the
+		// main bus points at a channel of the sidechain, mono keys them all,
+		// stereo the left and right channels of each pair. kParamSidechain
+		// may change within the block, processSubBlock picks the stages
+		void** side = nullptr;
+		int32 sideChannels = 0;
+		Vst::AudioBus* sidechain = getAudioInput(1);
+		if (sidechain && sidechain->isActive() &&
+			data.numInputs > 1 && data.inputs[1].numChannels > 0) {
+			side = getChannelBuffersPointer(processSetup, data.inputs[1]);
+			sideChannels = data.inputs[1].numChannels;
+			for (int32 ch = 0; side && ch < sideChannels; ch++)
+				if (!side[ch]) side = nullptr;
+		}
+
 		//---check if silence---------------
-		// normally we have to check each channel (simplification)
-		if (data.inputs[0].silenceFlags != 0) // if flags is not zero => then it means that we have silent!
+		// per channel, in processSubBlock: silent inputs are tracked until the
+		// tails have rung out, and outputs the gate has shut are flagged
+		uint64 inputSilence = data.inputs[0].silenceFlags;
+		uint64 outputSilence = ~(uint64)0;
+
+		int32 pos = 0;
+		while (pos < data.numSamples)
 		{
-			// in the example we are applying a gain to the input signal
-			// As we know that the input is only filled with zero, the output will be then filled with zero too!
+			int32 split = data.numSamples;
+			for (int32 c = 0; c < numCursors; c++)
+			{
+				QueueCursor& cursor = cursors[c];
+				for (; cursor.pending() && cursor.sampleOffset <= pos; cursor.next())
+					setParameter(cursor.id, cursor.value);
+				if (cursor.pending() && cursor.sampleOffset < split)
+					split = cursor.sampleOffset;
+			}
+			if (split < pos + kMinSubBlock)
+				split = (pos + kMinSubBlock < data.numSamples) ? pos + kMinSubBlock : data.numSamples;
 
-			data.outputs[0].silenceFlags = 0;
+			// a meter frame ends on a split of its own, unless that split would
+			// hold back an automation point by the kMinSubBlock rule above
+			int32 meterSplit = pos + std::max(meterFrameLength - meterSums.frames, kMinSubBlock);
+			if (meterSplit <= split - kMinSubBlock)
+				split = meterSplit;
 
-			if (data.inputs[0].silenceFlags & (uint64)1) { // Left
-				if (in[0] != out[0])
-					memset(out[0], 0, sampleFramesSize); // this is faster than applying a gain to each sample!
-				data.outputs[0].silenceFlags |= (uint64)1 << (uint64)0;
+			if (data.symbolicSampleSize == Vst::kSample32) {
+				Vst::Sample32* subIn[kMaxChannels];
+				Vst::Sample32* subOut[kMaxChannels];
+				Vst::Sample32* subKeys[kMaxChannels];
+				for (int32 ch = 0; ch < numChannels; ch++) {
+					subIn[ch] = (Vst::Sample32*)in[ch] + pos;
+					subOut[ch] = (Vst::Sample32*)out[ch] + pos;
+					if (side) subKeys[ch] = (Vst::Sample32*)side[ch % sideChannels] + pos;
+				}
+				outputSilence &= processSubBlock<Vst::Sample32>(subIn, subOut, getSampleRate, split - pos, Vst::kSample32, inputSilence, side ? subKeys : nullptr);
+			}
+			else if (data.symbolicSampleSize == Vst::kSample64) {
+				Vst::Sample64* subIn[kMaxChannels];
+				Vst::Sample64* subOut[kMaxChannels];
+				Vst::Sample64* subKeys[kMaxChannels];
+				for (int32 ch = 0; ch < numChannels; ch++) {
+					subIn[ch] = (Vst::Sample64*)in[ch] + pos;
+					subOut[ch] = (Vst::Sample64*)out[ch] + pos;
+					if (side) subKeys[ch] = (Vst::Sample64*)side[ch % sideChannels] + pos;
+				}
+				outputSilence &= processSubBlock<Vst::Sample64>(subIn, subOut, getSampleRate, split - pos, Vst::kSample64, inputSilence, side ? subKeys : nullptr);
 			}
 
-			if (data.inputs[0].silenceFlags & (uint64)2) { // Right
-				if (in[1] != out[1])
-					memset(out[1], 0, sampleFramesSize); // this is faster than applying a gain to each sample!
-				data.outputs[0].silenceFlags |= (uint64)1 << (uint64)1;
+			// a full frame goes to the controller, or is dropped if it has not
+			// asked for the last kMeterRingFrames
+			meterSums.frames += split - pos;
+			if (meterSums.frames >= meterFrameLength) {
+				loudness.addFrame(meterSums.outWeighted, meterSums.frames, meterSums.outTruePeak);
+				MeterFrame frame = meterSums.finish(numChannels);
+				loudness.fillFrame(frame);
+				meterRing.push(frame);
 			}
+			pos = split;
+		}
+		data.outputs[0].silenceFlags = outputSilence & ((numChannels < 64) ? ((uint64)1 << numChannels) - 1 : ~(uint64)0);
+		// points at or beyond the block end still set the state for the next block
+		for (int32 c = 0; c < numCursors; c++)
+			for (; cursors[c].pending(); cursors[c].next()) setParameter(cursors[c].id, cursors[c].value);
+		snapSmoothers = false;
+
+		// the meters no longer go out as parameter changes once per block,
+		// the controller collects the frames from meterRing (notify)
+		return kResultOk;
+	}
 
-			if (data.inputs[0].silenceFlags & (uint64)3) {
+	//------------------------------------------------------------------------
+	tresult PLUGIN_API lunchboxProcessor::notify(Vst::IMessage* message)
+	{
+		if (message && strcmp(message->getMessageID(), kLatencyRequestMessage) == 0)
+		{
+			// not answered until the audio thread has taken the new settings,
+			// so the host never asks too early
+			if (latencySamples.load(std::memory_order_relaxed) == reportedLatency.load(std::memory_order_relaxed))
 				return kResultOk;
+			IPtr<Vst::IMessage> reply = owned(allocateMessage());
+			if (!reply)
+				return kResultFalse;
+			reply->setMessageID(kLatencyChangedMessage);
+			return sendMessage(reply);
+		}
+		if (!message || strcmp(message->getMessageID(), kMeterRequestMessage) != 0)
+			return AudioEffect::notify(message);
+
+		// called on the controller's thread: the ring is emptied and the reply
+		// allocated here, the audio thread only ever pushes
+		MeterFrame frames[kMeterRingFrames];
+		uint32 count = 0;
+		while (count < kMeterRingFrames && meterRing.pop(frames[count]))
+			count++;
+		if (count == 0)
+			return kResultOk;
+
+		IPtr<Vst::IMessage> reply = owned(allocateMessage());
+		if (!reply)
+			return kResultFalse;
+		reply->setMessageID(kMeterFramesMessage);
+		reply->getAttributes()->setBinary(kMeterFramesAttribute, frames, count * sizeof(MeterFrame));
+		return sendMessage(reply);
+	}
+
+	//------------------------------------------------------------------------
+	void lunchboxProcessor::flushMeters()
+	{
+		// the interpolation around the last samples runs on into silence
+		auto flush = [&](auto& group) {
+			using V = typename std::decay_t<decltype(group)>::Lanes;
+			V truePeak = 0.0;
+			for (int n = 0; n < kTruePeakTaps; n++)
+			{
+				V oversampled = tickTruePeak(group.truePeak, V(0.0));
+				truePeak = select(oversampled > truePeak, oversampled, truePeak);
+			}
+			meterSums.outTruePeak = std::max(meterSums.outTruePeak, maxOfLanes(truePeak));
+		};
+		for (auto& group : pairs) flush(group);
+		if (numChannels & 1) flush(single);
+
+		loudness.addFrame(meterSums.outWeighted, meterSums.frames, meterSums.outTruePeak);
+		MeterFrame frame = meterSums.finish(numChannels);
+		loudness.fillFrame(frame);
+		meterRing.push(frame);
+	}
+
+
+	template <typename SampleType>
+	uint64 lunchboxProcessor::processSubBlock(SampleType** inputs, SampleType** outputs, Vst::Sample64 getSampleRate, int32 sampleFrames, int32 precision, uint64 inputSilence, SampleType** keys)
+	{
+		// hosts may not exceed maxSamplesPerBlock, the smoothing buffers are not longer
+		int32 capacity = smoothInput.getCapacity();
+		if (sampleFrames > capacity)
+		{
+			uint64 outputSilence = ~(uint64)0;
+			for (int32 done = 0; done < sampleFrames; done += capacity)
+			{
+				SampleType* chunkIn[kMaxChannels];
+				SampleType* chunkOut[kMaxChannels];
+				SampleType* chunkKeys[kMaxChannels];
+				for (int32 ch = 0; ch < numChannels; ch++) {
+					chunkIn[ch] = inputs[ch] + done;
+					chunkOut[ch] = outputs[ch] + done;
+					if (keys) chunkKeys[ch] = keys[ch] + done;
+				}
+				outputSilence &= processSubBlock<SampleType>(chunkIn, chunkOut, getSampleRate, std::min(capacity, sampleFrames - done), precision, inputSilence, keys ? chunkKeys : nullptr);
 			}
+			return outputSilence;
 		}
 
-		data.outputs[0].silenceFlags = data.inputs[0].silenceFlags;
+		uint32 sampleFramesSize = sampleFrames * sizeof(SampleType);
 
-		fParamInVuPPM = 0.f;
-		fParamOutVuPPM = 0.f;
-		fParamDeEssVuPPM = 1.f;
-		fParamCompVuPPM = 1.f;
-		
 		//---in bypass mode outputs should be like inputs-----
 		if (bParamBypass)
 		{
-			if (in[0] != out[0]) { memcpy(out[0], in[0], sampleFramesSize); }
-			if (in[1] != out[1]) { memcpy(out[1], in[1], sampleFramesSize); }
+			for (int32 ch = 0; ch < numChannels; ch++)
+				if (inputs[ch] != outputs[ch]) { memcpy(outputs[ch], inputs[ch], sampleFramesSize); }
 
-			if (data.symbolicSampleSize == Vst::kSample32) {
-				processBypass<Vst::Sample32>((Vst::Sample32**)in, getSampleRate, data.numSamples);
-			}
-			else if (data.symbolicSampleSize == Vst::kSample64) {
-				processBypass<Vst::Sample64>((Vst::Sample64**)in, getSampleRate, data.numSamples);
-			}
+			processBypass<SampleType>(inputs, getSampleRate, sampleFrames);
+			meterOutput<SampleType>(outputs, sampleFrames);
+			return inputSilence;
+		}
+
+		updateCoeffs(getSampleRate);
+
+		SampleType** compKeys = (iParamSidechain & kSidechainComp) ? keys : nullptr;
+		SampleType** gateKeys = (iParamSidechain & kSidechainGate) ? keys : nullptr;
+		detectSilence(inputs, sampleFrames, inputSilence, (compKeys || gateKeys) ? keys : nullptr);
+
+		if (fusedKernel)
+		{
+			processFused<SampleType>(inputs, outputs, getSampleRate, sampleFrames, precision, compKeys, gateKeys);
 		}
 		else
 		{
-			if (data.symbolicSampleSize == Vst::kSample32) {
-				processInput<Vst::Sample32>((Vst::Sample32**)in, getSampleRate, data.numSamples);
-				processChannel9<Vst::Sample32>((Vst::Sample32**)in, getSampleRate, data.numSamples);
-				processEQ<Vst::Sample32>((Vst::Sample32**)in, getSampleRate, data.numSamples);
-				processDeBess<Vst::Sample32>((Vst::Sample32**)in, getSampleRate, data.numSamples);
-				processComp<Vst::Sample32>((Vst::Sample32**)in, getSampleRate, data.numSamples);
-				processInflator<Vst::Sample32>((Vst::Sample32**)in, getSampleRate, data.numSamples);
-				processGate<Vst::Sample32>((Vst::Sample32**)in, getSampleRate, data.numSamples);
-				processOutput<Vst::Sample32>((Vst::Sample32**)in, getSampleRate, data.numSamples, Vst::kSample32);
-				memcpy(out[0], in[0], sampleFramesSize);
-				memcpy(out[1], in[1], sampleFramesSize);
-			}
-			else if (data.symbolicSampleSize == Vst::kSample64) {
-				processInput<Vst::Sample64>((Vst::Sample64**)in, getSampleRate, data.numSamples);
-				processChannel9<Vst::Sample64>((Vst::Sample64**)in, getSampleRate, data.numSamples);
-				processEQ<Vst::Sample64>((Vst::Sample64**)in, getSampleRate, data.numSamples);
-				processDeBess<Vst::Sample64>((Vst::Sample64**)in, getSampleRate, data.numSamples);
-				processComp<Vst::Sample64>((Vst::Sample64**)in, getSampleRate, data.numSamples);
-				processInflator<Vst::Sample64>((Vst::Sample64**)in, getSampleRate, data.numSamples);
-				processGate<Vst::Sample64>((Vst::Sample64**)in, getSampleRate, data.numSamples);
-				processOutput<Vst::Sample64>((Vst::Sample64**)in, getSampleRate, data.numSamples, Vst::kSample64);
-				memcpy(out[0], in[0], sampleFramesSize);
-				memcpy(out[1], in[1], sampleFramesSize);
-			}
+			// the host's input is only read: Input writes to the outputs and
+			// every later stage works on them in place
+			processInput<SampleType>(inputs, outputs, getSampleRate, sampleFrames);
+			processChannel9<SampleType>(outputs, outputs, getSampleRate, sampleFrames);
+			processEQ<SampleType>(outputs, outputs, getSampleRate, sampleFrames);
+			processDeBess<SampleType>(outputs, outputs, getSampleRate, sampleFrames);
+			processComp<SampleType>(outputs, outputs, getSampleRate, sampleFrames, compKeys);
+			processInflator<SampleType>(outputs, outputs, getSampleRate, sampleFrames);
+			if (bParamSafe) processLimiter<SampleType>(outputs, outputs, getSampleRate, sampleFrames);
+			processGate<SampleType>(outputs, outputs, getSampleRate, sampleFrames, gateKeys);
+			if (outputStage) processOutput<SampleType>(outputs, outputs, getSampleRate, sampleFrames, precision);
 		}
 
-		//---3) Write outputs parameter changes-----------
-		Vst::IParameterChanges* outParamChanges = data.outputParameterChanges;
-		// a new value of VuMeter will be send to the host
-		// (the host will send it back in sync to our controller for updating our editor)
-		if (outParamChanges)
-		{
-			int32 index = 0;
-			Vst::IParamValueQueue* paramQueue = outParamChanges->addParameterData(kParamInVuPPM, index);
-			if (paramQueue)
-			{
-				int32 index2 = 0;
-				paramQueue->addPoint(0, fParamInVuPPM, index2);
-			}
+		uint64 outputSilence = applySilence(outputs, sampleFrames);
+		meterOutput<SampleType>(outputs, sampleFrames);
+		return outputSilence;
+	}
 
-			index = 0;
-			paramQueue = outParamChanges->addParameterData(kParamOutVuPPM, index);
-			if (paramQueue)
-			{
-				int32 index2 = 0;
-				paramQueue->addPoint(0, fParamOutVuPPM, index2);
-			}
+	//------------------------------------------------------------------------
+	// Silence
+	// A group whose input has been digital silence for longer than the chain
+	// rings on (tailFrames) sleeps: the stages skip it and its outputs are
+	// zero, until a sample of its input, or of the sidechain keying MeowMu or
+	// the Gate, is not. It wakes up with fresh detectors, as after a silence
+	// that long they would be anyway, rather than the ones it fell asleep with.
+	// Independently, a lane whose gate stayed fully shut for a whole block
+	// (and for as long as the downsampler after it rings on) puts out digital
+	// silence instead of the Output dither on zero, and is flagged as such.
+	//------------------------------------------------------------------------
+	template <typename SampleType>
+	inline bool isSilent(const SampleType* channel, int32 sampleFrames)
+	{
+		for (int32 n = 0; n < sampleFrames; n++)
+			if (channel[n] != 0) return false;
+		return true;
+	}
 
-			index = 0;
-			paramQueue = outParamChanges->addParameterData(kParamDeEssVuPPM, index);
-			if (paramQueue)
-			{
-				int32 index2 = 0;
-				paramQueue->addPoint(0, fParamDeEssVuPPM, index2);
+	template <typename SampleType>
+	void lunchboxProcessor::detectSilence(SampleType** inputs, int32 sampleFrames, uint64 inputSilence, SampleType** keys)
+	{
+		auto detect = [&](auto& group, int32 first) {
+			const int32 lanes = std::decay_t<decltype(group)>::Lanes::kLanes;
+			bool silent = true;
+			for (int32 i = 0; i < lanes && silent; i++)
+				silent = ((inputSilence & ((uint64)1 << (first + i))) || isSilent(inputs[first + i], sampleFrames)) &&
+					(!keys || isSilent(keys[first + i], sampleFrames));
+			if (!silent) group.silentFrames = 0;
+			bool sleeping = silent && group.silentFrames >= tailFrames;
+			if (group.sleeping && !sleeping) {
+				group.deBess = decltype(group.deBess)();
+				group.comp = decltype(group.comp)();
+				group.gate = decltype(group.gate)();
+				group.deBessLink = DeBessState<Double1>();
+				group.compLink = CompState<Double1>();
+				group.compKey = decltype(group.compKey)();
+				group.gateKey = decltype(group.gateKey)();
 			}
+			group.sleeping = sleeping;
+			if (silent) group.silentFrames = std::min(group.silentFrames + sampleFrames, INT32_MAX / 2);
+		};
+		for (size_t g = 0; g < pairs.size(); g++) detect(pairs[g], (int32)(2 * g));
+		if (numChannels & 1) detect(single, numChannels - 1);
+	}
 
-			index = 0;
-			paramQueue = outParamChanges->addParameterData(kParamCompVuPPM, index);
-			if (paramQueue)
-			{
-				int32 index2 = 0;
-				paramQueue->addPoint(0, fParamCompVuPPM, index2);
+	template <typename SampleType>
+	uint64 lunchboxProcessor::applySilence(SampleType** outputs, int32 sampleFrames)
+	{
+		uint64 outputSilence = 0;
+		auto apply = [&](auto& group, int32 first) {
+			const int32 lanes = std::decay_t<decltype(group)>::Lanes::kLanes;
+			for (int32 i = 0; i < lanes; i++) {
+				if (group.sleeping || group.gateShutFrames[i] >= sampleFrames + gateTailFrames) {
+					memset(outputs[first + i], 0, sampleFrames * sizeof(SampleType));
+					outputSilence |= (uint64)1 << (first + i);
+				}
 			}
+		};
+		for (size_t g = 0; g < pairs.size(); g++) apply(pairs[g], (int32)(2 * g));
+		if (numChannels & 1) apply(single, numChannels - 1);
+		return outputSilence;
+	}
 
-		}
-		fParamInVuPPMOld = fParamInVuPPM;
-		fParamOutVuPPMOld = fParamOutVuPPM;
-		fParamDeEssVuPPMOld = fParamDeEssVuPPM;
-		fParamCompVuPPMOld = fParamCompVuPPM;
+	template <typename V>
+	void lunchboxProcessor::trackGate(ChannelGroup<V>& group, const V& gateOpen, int32 sampleFrames)
+	{
+		double open[V::kLanes];
+		gateOpen.store(open);
+		for (int i = 0; i < V::kLanes; i++)
+			group.gateShutFrames[i] = (open[i] == 0.0) ? std::min(group.gateShutFrames[i] + sampleFrames, INT32_MAX / 2) : 0;
+	}
 
-		return kResultOk;
+	/** Samples a biquad with these poles takes to ring down to -120 dB */
+	inline double getDecaySamples(double a1, double a2)
+	{
+		double radius;
+		double disc = a1 * a1 - 4.0 * a2;
+		if (disc >= 0.0) radius = std::max(fabs(-a1 + sqrt(disc)), fabs(-a1 - sqrt(disc))) * 0.5;
+		else radius = sqrt(a2);
+		if (radius <= 0.0) return 2.0;
+		if (radius >= 1.0) return 0.0;	// not stable, nothing to wait for
+		return log(1e-6) / log(radius) + 2.0;
 	}
 
+	void lunchboxProcessor::updateTail()
+	{
+		const double factor = oversampler.getFactor();
+
+		// Channel9: its biquads at the oversampled rate
+		double tail = std::max(getDecaySamples(channel9Coeffs.biquadA[5], channel9Coeffs.biquadA[6]),
+			getDecaySamples(channel9Coeffs.biquadB[5], channel9Coeffs.biquadB[6])) / factor;
+
+		// EQ: the slowest band, the 10Hz one, and the 1.2kHz peak after it
+		double eq = 0.0;
+		for (int b = 0; b < EQCoeffs::kBands; b++)
+			eq = std::max(eq, getDecaySamples(eqCoeffs.a1[b], eqCoeffs.a2[b]));
+		tail += eq + getDecaySamples(eqCoeffs.p_1k2[1], eqCoeffs.p_1k2[2]);
+
+		// DeBess: its slew history
+		tail += DeBessState<Double1>::kMaxLength + 1;
+
+		// MeowMu: the gain back to within -60 dB of unity, muCoefficientA / B
+		// approach it by 1 - 1 / release every other sample, the efficient
+		// follower by its release coefficient every sample
+		if (compCoeffs.efficient) {
+			if (compCoeffs.releaseCoeff > 0.0 && compCoeffs.releaseCoeff < 1.0)
+				tail += log(1e-3) / log(1.0 - compCoeffs.releaseCoeff);
+		}
+		else if (compCoeffs.release > 1.0)
+			tail += 2.0 * log(1e-3) / log(1.0 - 1.0 / compCoeffs.release);
+
+		// Limiter: its lookahead
+		if (bParamSafe) tail += limiterCoeffs.lookahead + kLimiterDetectorDelay;
 
-	template <typename SampleType>
-	void lunchboxProcessor::processChannel9(SampleType** inputs, Vst::Sample64 getSampleRate, int32 sampleFrames)
+		// Gate: fully closed from the longest hold
+		tail += gateCoeffs.absmax / (gateCoeffs.release * factor);
+
+		// the up- and downsamplers around Channel9, Inflator and Gate
+		gateTailFrames = (int32)getOversamplerTail(oversampler);
+		tail += kOversampledStages * gateTailFrames;
+
+		tailFrames = (int32)std::min(ceil(tail), (double)(INT32_MAX / 4));
+		tailSamples.store((uint32)tailFrames, std::memory_order_relaxed);
+	}
+
+	//------------------------------------------------------------------------
+	// Stages
+	// Every stage is split into a per-block prepareX(), which works out the
+	// coefficients from the parameters, and a per-sample kernel, which
+	// carries one sample of a channel group through the stage
+	// (lunchboxkernels.h). processX() runs one stage over a buffer,
+	// processFused() runs all of them sample by sample.
+	//------------------------------------------------------------------------
+	void lunchboxProcessor::updateCoeffs(Vst::Sample64 getSampleRate)
 	{
-		SampleType* in1 = inputs[0];
-		SampleType* in2 = inputs[1];
+		applySettings();
+		if (getSampleRate != coeffsSampleRate) {
+			coeffsSampleRate = getSampleRate;
+			dirtyCoeffs = kDirtyAll;
+		}
+		if (dirtyCoeffs == 0) return;
+
+		if (dirtyCoeffs & kDirtyChannel9) prepareChannel9(getSampleRate * oversampler.getFactor(), channel9Coeffs);
+		if (dirtyCoeffs & kDirtyEQ) prepareEQ(eqCoeffs);
+		if (dirtyCoeffs & kDirtyDeBess) prepareDeBess(getSampleRate, deBessCoeffs);
+		if (dirtyCoeffs & kDirtyComp) prepareComp(getSampleRate, compCoeffs);
+		if (dirtyCoeffs & kDirtyGate) prepareGate(getSampleRate, gateCoeffs);
+		if (dirtyCoeffs & kDirtyInflator) prepareInflator(inflatorCoeffs);
+		if (dirtyCoeffs & kDirtyLimiter) prepareLimiter(getSampleRate, limiterCoeffs);
+		dirtyCoeffs = 0;
+
+		updateTail();
+		updateLatency(getSampleRate);
+	}
 
+	void lunchboxProcessor::prepareChannel9(Vst::Sample64 getSampleRate, Channel9Coeffs& c)
+	{
 		double overallscale = 1.0;
 		overallscale /= 44100.0;
 		overallscale *= getSampleRate;
-		double localiirAmount = iirAmount / overallscale;
-		double localthreshold = threshold; //we've learned not to try and adjust threshold for sample rate
-		double density = fParamDrive; //0-2, originally at "* 2.0"
-		double phattity = density - 1.0;
-		if (density > 1.0) density = 1.0; //max out at full wet for Spiral aspect
-		if (phattity < 0.0) phattity = 0.0; //
-		double nonLin = 5.0 - density; //number is smaller for more intense, larger for more subtle
-		biquadB[0] = biquadA[0] = cutoff / getSampleRate;
-		biquadA[1] = 1.618033988749894848204586;
-		biquadB[1] = 0.618033988749894848204586;
-
-		double K = tan(M_PI * biquadA[0]); //lowpass
-		double norm = 1.0 / (1.0 + K / biquadA[1] + K * K);
-		biquadA[2] = K * K * norm;
-		biquadA[3] = 2.0 * biquadA[2];
-		biquadA[4] = biquadA[2];
-		biquadA[5] = 2.0 * (K * K - 1.0) * norm;
-		biquadA[6] = (1.0 - K / biquadA[1] + K * K) * norm;
-
-		K = tan(M_PI * biquadA[0]);
-		norm = 1.0 / (1.0 + K / biquadB[1] + K * K);
-		biquadB[2] = K * K * norm;
-		biquadB[3] = 2.0 * biquadB[2];
-		biquadB[4] = biquadB[2];
-		biquadB[5] = 2.0 * (K * K - 1.0) * norm;
-		biquadB[6] = (1.0 - K / biquadB[1] + K * K) * norm;
-
-		while (--sampleFrames >= 0)
-		{
-			double inputSampleL = *in1;
-			double inputSampleR = *in2;
-
-			double tempSample;
-
-			if (biquadA[0] < 0.49999) {
-				tempSample = biquadA[2] * inputSampleL + biquadA[3] * biquadA[7] + biquadA[4] * biquadA[8] - biquadA[5] * biquadA[9] - biquadA[6] * biquadA[10];
-				biquadA[8] = biquadA[7]; biquadA[7] = inputSampleL; if (fabs(tempSample) < 1.18e-37) tempSample = 0.0; inputSampleL = tempSample;
-				biquadA[10] = biquadA[9]; biquadA[9] = inputSampleL; //DF1 left
-				tempSample = biquadA[2] * inputSampleR + biquadA[3] * biquadA[11] + biquadA[4] * biquadA[12] - biquadA[5] * biquadA[13] - biquadA[6] * biquadA[14];
-				biquadA[12] = biquadA[11]; biquadA[11] = inputSampleR; if (fabs(tempSample) < 1.18e-37) tempSample = 0.0; inputSampleR = tempSample;
-				biquadA[14] = biquadA[13]; biquadA[13] = inputSampleR; //DF1 right
-			}
+		c.localiirAmount = iirAmount / overallscale;
+		c.localthreshold = threshold; //we've learned not to try and adjust threshold for sample rate
+		c.biquadB[0] = c.biquadA[0] = cutoff / getSampleRate;
+		c.biquadA[1] = 1.618033988749894848204586;
+		c.biquadB[1] = 0.618033988749894848204586;
+
+		double K = tan(M_PI * c.biquadA[0]); //lowpass
+		double norm = 1.0 / (1.0 + K / c.biquadA[1] + K * K);
+		c.biquadA[2] = K * K * norm;
+		c.biquadA[3] = 2.0 * c.biquadA[2];
+		c.biquadA[4] = c.biquadA[2];
+		c.biquadA[5] = 2.0 * (K * K - 1.0) * norm;
+		c.biquadA[6] = (1.0 - K / c.biquadA[1] + K * K) * norm;
+
+		K = tan(M_PI * c.biquadA[0]);
+		norm = 1.0 / (1.0 + K / c.biquadB[1] + K * K);
+		c.biquadB[2] = K * K * norm;
+		c.biquadB[3] = 2.0 * c.biquadB[2];
+		c.biquadB[4] = c.biquadB[2];
+		c.biquadB[5] = 2.0 * (K * K - 1.0) * norm;
+		c.biquadB[6] = (1.0 - K / c.biquadB[1] + K * K) * norm;
+
+		c.precise = preciseMath;
+	}
 
-			double dielectricScaleL = fabs(2.0 - ((inputSampleL + nonLin) / nonLin));
-			double dielectricScaleR = fabs(2.0 - ((inputSampleR + nonLin) / nonLin));
+	template <typename SampleType>
+	void lunchboxProcessor::processChannel9(SampleType** inputs, SampleType** outputs, Vst::Sample64 getSampleRate, int32 sampleFrames)
+	{
+		updateCoeffs(getSampleRate);
+		const Channel9Coeffs& coeffs = channel9Coeffs;
+		const Vst::Sample64* drive = smoothDrive.process(sampleFrames);
 
-			if (flip_channel9)
-			{
-				if (fabs(iirSampleLA) < 1.18e-37) iirSampleLA = 0.0;
-				iirSampleLA = (iirSampleLA * (1.0 - (localiirAmount * dielectricScaleL))) + (inputSampleL * localiirAmount * dielectricScaleL);
-				inputSampleL = inputSampleL - iirSampleLA;
-				if (fabs(iirSampleRA) < 1.18e-37) iirSampleRA = 0.0;
-				iirSampleRA = (iirSampleRA * (1.0 - (localiirAmount * dielectricScaleR))) + (inputSampleR * localiirAmount * dielectricScaleR);
-				inputSampleR = inputSampleR - iirSampleRA;
-			}
-			else
+		forEachGroup(inputs, outputs, [&](auto& group, SampleType** in, SampleType** out) {
+			using V = typename std::decay_t<decltype(group)>::Lanes;
+			for (int32 n = 0; n < sampleFrames; n++)
 			{
-				if (fabs(iirSampleLB) < 1.18e-37) iirSampleLB = 0.0;
-				iirSampleLB = (iirSampleLB * (1.0 - (localiirAmount * dielectricScaleL))) + (inputSampleL * localiirAmount * dielectricScaleL);
-				inputSampleL = inputSampleL - iirSampleLB;
-				if (fabs(iirSampleRB) < 1.18e-37) iirSampleRB = 0.0;
-				iirSampleRB = (iirSampleRB * (1.0 - (localiirAmount * dielectricScaleR))) + (inputSampleR * localiirAmount * dielectricScaleR);
-				inputSampleR = inputSampleR - iirSampleRB;
+				V inputSample = loadFrame<V>(in, n);
+				tickOversampled(group.overChannel9, oversampler, inputSample, [&](V& sample) {
+					tickChannel9(group.channel9, sample, coeffs, drive[n]);
+				});
+				storeFrame(inputSample, out, n);
 			}
-			//highpass section
-			double drySampleL = inputSampleL;
-			double drySampleR = inputSampleR;
-
-			if (inputSampleL > 1.0) inputSampleL = 1.0;
-			if (inputSampleL < -1.0) inputSampleL = -1.0;
-			double phatSampleL = sin(inputSampleL * 1.57079633);
-			inputSampleL *= 1.2533141373155;
-			//clip to 1.2533141373155 to reach maximum output, or 1.57079633 for pure sine 'phat' version
-
-			double distSampleL = sin(inputSampleL * fabs(inputSampleL)) / ((fabs(inputSampleL) == 0.0) ? 1 : fabs(inputSampleL));
-
-			inputSampleL = distSampleL; //purest form is full Spiral
-			if (density < 1.0) inputSampleL = (drySampleL * (1 - density)) + (distSampleL * density); //fade Spiral aspect
-			if (phattity > 0.0) inputSampleL = (inputSampleL * (1 - phattity)) + (phatSampleL * phattity); //apply original Density on top
-
-			if (inputSampleR > 1.0) inputSampleR = 1.0;
-			if (inputSampleR < -1.0) inputSampleR = -1.0;
-			double phatSampleR = sin(inputSampleR * 1.57079633);
-			inputSampleR *= 1.2533141373155;
-			//clip to 1.2533141373155 to reach maximum output, or 1.57079633 for pure sine 'phat' version
-
-			double distSampleR = sin(inputSampleR * fabs(inputSampleR)) / ((fabs(inputSampleR) == 0.0) ? 1 : fabs(inputSampleR));
-
-			inputSampleR = distSampleR; //purest form is full Spiral
-			if (density < 1.0) inputSampleR = (drySampleR * (1 - density)) + (distSampleR * density); //fade Spiral aspect
-			if (phattity > 0.0) inputSampleR = (inputSampleR * (1 - phattity)) + (phatSampleR * phattity); //apply original Density on top
-
-			//begin L
-			double clamp = (lastSampleBL - lastSampleCL) * 0.381966011250105;
-			clamp -= (lastSampleAL - lastSampleBL) * 0.6180339887498948482045;
-			clamp += inputSampleL - lastSampleAL; //regular slew clamping added
-
-			lastSampleCL = lastSampleBL;
-			lastSampleBL = lastSampleAL;
-			lastSampleAL = inputSampleL; //now our output relates off lastSampleB
-
-			if (clamp > localthreshold)
-				inputSampleL = lastSampleBL + localthreshold;
-			if (-clamp > localthreshold)
-				inputSampleL = lastSampleBL - localthreshold;
-
-			lastSampleAL = (lastSampleAL * 0.381966011250105) + (inputSampleL * 0.6180339887498948482045); //split the difference between raw and smoothed for buffer
-			//end L
-
-			//begin R
-			clamp = (lastSampleBR - lastSampleCR) * 0.381966011250105;
-			clamp -= (lastSampleAR - lastSampleBR) * 0.6180339887498948482045;
-			clamp += inputSampleR - lastSampleAR; //regular slew clamping added
-
-			lastSampleCR = lastSampleBR;
-			lastSampleBR = lastSampleAR;
-			lastSampleAR = inputSampleR; //now our output relates off lastSampleB
-
-			if (clamp > localthreshold)
-				inputSampleR = lastSampleBR + localthreshold;
-			if (-clamp > localthreshold)
-				inputSampleR = lastSampleBR - localthreshold;
-
-			lastSampleAR = (lastSampleAR * 0.381966011250105) + (inputSampleR * 0.6180339887498948482045); //split the difference between raw and smoothed for buffer
-			//end R
-
-			flip_channel9 = !flip_channel9;
-
-			if (biquadB[0] < 0.49999) {
-				tempSample = biquadB[2] * inputSampleL + biquadB[3] * biquadB[7] + biquadB[4] * biquadB[8] - biquadB[5] * biquadB[9] - biquadB[6] * biquadB[10];
-				biquadB[8] = biquadB[7]; biquadB[7] = inputSampleL; if (fabs(tempSample) < 1.18e-37) tempSample = 0.0; inputSampleL = tempSample;
-				biquadB[10] = biquadB[9]; biquadB[9] = inputSampleL; //DF1 left
-				tempSample = biquadB[2] * inputSampleR + biquadB[3] * biquadB[11] + biquadB[4] * biquadB[12] - biquadB[5] * biquadB[13] - biquadB[6] * biquadB[14];
-				biquadB[12] = biquadB[11]; biquadB[11] = inputSampleR; if (fabs(tempSample) < 1.18e-37) tempSample = 0.0; inputSampleR = tempSample;
-				biquadB[14] = biquadB[13]; biquadB[13] = inputSampleR; //DF1 right
-			}
-
-			*in1 = inputSampleL;
-			*in2 = inputSampleR;
-
-			in1++;
-			in2++;
-		}
+		});
 	}
 
-	template <typename SampleType>
-	void lunchboxProcessor::processEQ(SampleType** inputs, Vst::Sample64 getSampleRate, int32 sampleFrames) {
-		SampleType* in1 = (SampleType*)inputs[0];
-		SampleType* in2 = (SampleType*)inputs[1];
-
+	//------------------------------------------------------------------------
+	void lunchboxProcessor::prepareEQ(EQCoeffs& c)
+	{
 		Vst::Sample64 x[6], g[5], pg[5];
-		Vst::Sample64 g_10, pg_10;
-		Vst::Sample64 g_40, pg_40;
-		Vst::Sample64 g_160, pg_160;
-		Vst::Sample64 g_640, pg_640;
-		Vst::Sample64 g_2k5, pg_2k5;
-		Vst::Sample64 g_20k, pg_20k;
-
-		Vst::Sample64 peakGain = (12.0 * fParamFocus - 6.0);
-		Vst::Sample64 V_1k2 = pow(10, abs(peakGain) / 20);
-		Vst::Sample64 QK, VQK;
-		if (peakGain > 0.0) {
-			QK = 1 / Q_1k2 * K_1k2;
-			VQK = V_1k2 / Q_1k2 * K_1k2;
-		}
-		else {
-			QK = V_1k2 / Q_1k2 * K_1k2;
-			VQK = 1 / Q_1k2 * K_1k2;
-		}
-		Vst::Sample64 norm_1k2 = 1 / (1 + QK + K_1k2_2);
-		z_1k2[0] = (1 + VQK + K_1k2_2) * norm_1k2;
-		z_1k2[1] = 2 * (K_1k2_2 - 1) * norm_1k2;
-		z_1k2[2] = (1 - VQK + K_1k2_2) * norm_1k2;
-		p_1k2[0] = 1.0;
-		p_1k2[1] = z_1k2[1];
-		p_1k2[2] = (1 - QK + K_1k2_2) * norm_1k2;
 
 		if (bParamLowcut) {
 			x[0] = 0.0; // 10hz
@@ -474,779 +841,640 @@ namespace yg331 {
 			}
 		}
 		if (x[5] > 0.5)
-			g_20k = 0.5 * 56.2 / (5.56 + (3258.2 * exp(-7.4126 * x[5]) - 1.8466));
+			c.g_20k = 0.5 * 56.2 / (5.56 + (3258.2 * exp(-7.4126 * x[5]) - 1.8466));
 		else
-			g_20k = 0.5 * 56.2 / (5.56 + (500.0 - 823.6 * x[5]));
-		pg_20k = 1.0;
-
-		g_10 = g[0]; pg_10 = pg[0];
-		g_40 = g[1]; pg_40 = pg[1];
-		g_160 = g[2]; pg_160 = pg[2];
-		g_640 = g[3]; pg_640 = pg[3];
-		g_2k5 = g[4]; pg_2k5 = pg[4];
-
-
-		Vst::Sample64 dcGain = g_10 + g_40 + g_160 + g_640 + g_2k5 + g_20k;
-		Vst::Sample64 globalGain = 0.398 / dcGain;
-
-		while (--sampleFrames >= 0)
-		{
-			Vst::Sample64 inputSampleL = *in1;
-			Vst::Sample64 inputSampleR = *in2;
-
-			Vst::Sample64 dataOutL = 0.0;
-			Vst::Sample64 dataOutR = 0.0;
-
-			/*
-			dataOutL += (y_1k2_L[0] * pg_1k2 + inputSampleL) * g_1k2;
-			dataOutR += (y_1k2_R[0] * pg_1k2 + inputSampleR) * g_1k2;
-			*/
-
-			x_10_L[0] = inputSampleL;
-			x_40_L[0] = inputSampleL;
-			x_160_L[0] = inputSampleL;
-			x_640_L[0] = inputSampleL;
-			x_2k5_L[0] = inputSampleL;
-			x_20k_L[0] = inputSampleL;
-
-			// 10Hz
-			y_10_L[0] = x_10_L[0] * z_10[0] + x_10_L[1] * z_10[1] + x_10_L[2] * z_10[2] - y_10_L[1] * p_10[1] - y_10_L[2] * p_10[2];
-			x_10_L[2] = x_10_L[1];  x_10_L[1] = x_10_L[0];  y_10_L[2] = y_10_L[1];  y_10_L[1] = y_10_L[0];
-
-			// 40Hz
-			y_40_L[0] = x_40_L[0] * z_40[0] + x_40_L[1] * z_40[1] + x_40_L[2] * z_40[2] - y_40_L[1] * p_40[1] - y_40_L[2] * p_40[2];
-			x_40_L[2] = x_40_L[1];  x_40_L[1] = x_40_L[0];  y_40_L[2] = y_40_L[1];  y_40_L[1] = y_40_L[0];
-
-			// 160Hz
-			y_160_L[0] = x_160_L[0] * z_160[0] + x_160_L[1] * z_160[1] + x_160_L[2] * z_160[2] - y_160_L[1] * p_160[1] - y_160_L[2] * p_160[2];
-			x_160_L[2] = x_160_L[1];  x_160_L[1] = x_160_L[0];  y_160_L[2] = y_160_L[1];  y_160_L[1] = y_160_L[0];
-
-			// 640Hz
-			y_640_L[0] = x_640_L[0] * z_640[0] + x_640_L[1] * z_640[1] + x_640_L[2] * z_640[2] - y_640_L[1] * p_640[1] - y_640_L[2] * p_640[2];
-			x_640_L[2] = x_640_L[1];  x_640_L[1] = x_640_L[0];  y_640_L[2] = y_640_L[1];  y_640_L[1] = y_640_L[0];
-
-			// 2500Hz
-			y_2k5_L[0] = x_2k5_L[0] * z_2k5[0] + x_2k5_L[1] * z_2k5[1] + x_2k5_L[2] * z_2k5[2] - y_2k5_L[1] * p_2k5[1] - y_2k5_L[2] * p_2k5[2];
-			x_2k5_L[2] = x_2k5_L[1];  x_2k5_L[1] = x_2k5_L[0];  y_2k5_L[2] = y_2k5_L[1];  y_2k5_L[1] = y_2k5_L[0];
-
-			// 20kHz
-			y_20k_L[0] = x_20k_L[0] * z_20k[0] + x_20k_L[1] * z_20k[1] + x_20k_L[2] * z_20k[2] - y_20k_L[1] * p_20k[1] - y_20k_L[2] * p_20k[2];
-			x_20k_L[2] = x_20k_L[1];  x_20k_L[1] = x_20k_L[0];  y_20k_L[2] = y_20k_L[1];  y_20k_L[1] = y_20k_L[0];
-
-			dataOutL += (y_10_L[0] * pg_10 + inputSampleL) * g_10;
-			dataOutL += (y_40_L[0] * pg_40 + inputSampleL) * g_40;
-			dataOutL += (y_160_L[0] * pg_160 + inputSampleL) * g_160;
-			dataOutL += (y_640_L[0] * pg_640 + inputSampleL) * g_640;
-			dataOutL += (y_2k5_L[0] * pg_2k5 + inputSampleL) * g_2k5;
-			dataOutL += (y_20k_L[0] * pg_20k + inputSampleL) * g_20k;
-
-			x_10_R[0] = inputSampleR;
-			x_40_R[0] = inputSampleR;
-			x_160_R[0] = inputSampleR;
-			x_640_R[0] = inputSampleR;
-			x_2k5_R[0] = inputSampleR;
-			x_20k_R[0] = inputSampleR;
-
-			// 10Hz
-			y_10_R[0] = x_10_R[0] * z_10[0] + x_10_R[1] * z_10[1] + x_10_R[2] * z_10[2] - y_10_R[1] * p_10[1] - y_10_R[2] * p_10[2];
-			x_10_R[2] = x_10_R[1];  x_10_R[1] = x_10_R[0];  y_10_R[2] = y_10_R[1];  y_10_R[1] = y_10_R[0];
-
-			// 40Hz
-			y_40_R[0] = x_40_R[0] * z_40[0] + x_40_R[1] * z_40[1] + x_40_R[2] * z_40[2] - y_40_R[1] * p_40[1] - y_40_R[2] * p_40[2];
-			x_40_R[2] = x_40_R[1];  x_40_R[1] = x_40_R[0];  y_40_R[2] = y_40_R[1];  y_40_R[1] = y_40_R[0];
-
-			// 160Hz
-			y_160_R[0] = x_160_R[0] * z_160[0] + x_160_R[1] * z_160[1] + x_160_R[2] * z_160[2] - y_160_R[1] * p_160[1] - y_160_R[2] * p_160[2];
-			x_160_R[2] = x_160_R[1];  x_160_R[1] = x_160_R[0];  y_160_R[2] = y_160_R[1];  y_160_R[1] = y_160_R[0];
-
-			// 640Hz
-			y_640_R[0] = x_640_R[0] * z_640[0] + x_640_R[1] * z_640[1] + x_640_R[2] * z_640[2] - y_640_R[1] * p_640[1] - y_640_R[2] * p_640[2];
-			x_640_R[2] = x_640_R[1];  x_640_R[1] = x_640_R[0];  y_640_R[2] = y_640_R[1];  y_640_R[1] = y_640_R[0];
-
-			// 2500Hz
-			y_2k5_R[0] = x_2k5_R[0] * z_2k5[0] + x_2k5_R[1] * z_2k5[1] + x_2k5_R[2] * z_2k5[2] - y_2k5_R[1] * p_2k5[1] - y_2k5_R[2] * p_2k5[2];
-			x_2k5_R[2] = x_2k5_R[1];  x_2k5_R[1] = x_2k5_R[0];  y_2k5_R[2] = y_2k5_R[1];  y_2k5_R[1] = y_2k5_R[0];
-
-			// 20kHz
-			y_20k_R[0] = x_20k_R[0] * z_20k[0] + x_20k_R[1] * z_20k[1] + x_20k_R[2] * z_20k[2] - y_20k_R[1] * p_20k[1] - y_20k_R[2] * p_20k[2];
-			x_20k_R[2] = x_20k_R[1];  x_20k_R[1] = x_20k_R[0];  y_20k_R[2] = y_20k_R[1];  y_20k_R[1] = y_20k_R[0];
-
-			dataOutR += (y_10_R[0] * pg_10 + inputSampleR) * g_10;
-			dataOutR += (y_40_R[0] * pg_40 + inputSampleR) * g_40;
-			dataOutR += (y_160_R[0] * pg_160 + inputSampleR) * g_160;
-			dataOutR += (y_640_R[0] * pg_640 + inputSampleR) * g_640;
-			dataOutR += (y_2k5_R[0] * pg_2k5 + inputSampleR) * g_2k5;
-			dataOutR += (y_20k_R[0] * pg_20k + inputSampleR) * g_20k;
-
-			dataOutL = dataOutL * globalGain;
-			dataOutR = dataOutR * globalGain;
-
-			x_1k2_L[0] = dataOutL;
-			x_1k2_R[0] = dataOutR;
-			// 1200Hz
-			y_1k2_L[0] = x_1k2_L[0] * z_1k2[0] + x_1k2_L[1] * z_1k2[1] + x_1k2_L[2] * z_1k2[2] - y_1k2_L[1] * p_1k2[1] - y_1k2_L[2] * p_1k2[2];
-			x_1k2_L[2] = x_1k2_L[1];  x_1k2_L[1] = x_1k2_L[0];  y_1k2_L[2] = y_1k2_L[1];  y_1k2_L[1] = y_1k2_L[0];
-			// 1200Hz
-			y_1k2_R[0] = x_1k2_R[0] * z_1k2[0] + x_1k2_R[1] * z_1k2[1] + x_1k2_R[2] * z_1k2[2] - y_1k2_R[1] * p_1k2[1] - y_1k2_R[2] * p_1k2[2];
-			x_1k2_R[2] = x_1k2_R[1];  x_1k2_R[1] = x_1k2_R[0];  y_1k2_R[2] = y_1k2_R[1];  y_1k2_R[1] = y_1k2_R[0];
-			dataOutL = y_1k2_L[0];
-			dataOutR = y_1k2_R[0];
-
-
-			*in1 = dataOutL;
-			*in2 = dataOutR;
-
-			in1++;
-			in2++;
+			c.g_20k = 0.5 * 56.2 / (5.56 + (500.0 - 823.6 * x[5]));
+		c.pg_20k = 1.0;
+
+		c.g_10 = g[0]; c.pg_10 = pg[0];
+		c.g_40 = g[1]; c.pg_40 = pg[1];
+		c.g_160 = g[2]; c.pg_160 = pg[2];
+		c.g_640 = g[3]; c.pg_640 = pg[3];
+		c.g_2k5 = g[4]; c.pg_2k5 = pg[4];
+
+
+		Vst::Sample64 dcGain = c.g_10 + c.g_40 + c.g_160 + c.g_640 + c.g_2k5 + c.g_20k;
+		c.globalGain = 0.398 / dcGain;
+
+		// (y * pg + x) * g per band, all times globalGain: the wet part scales
+		// the numerator of the band, the dry parts add up to one gain
+		const double* z[EQCoeffs::kBands] = { c.z_10, c.z_40, c.z_160, c.z_640, c.z_2k5, c.z_20k };
+		const double* p[EQCoeffs::kBands] = { c.p_10, c.p_40, c.p_160, c.p_640, c.p_2k5, c.p_20k };
+		const double wet[EQCoeffs::kBands] = {
+			c.g_10 * c.pg_10, c.g_40 * c.pg_40, c.g_160 * c.pg_160,
+			c.g_640 * c.pg_640, c.g_2k5 * c.pg_2k5, c.g_20k * c.pg_20k };
+		for (int b = 0; b < EQCoeffs::kBands; b++) {
+			c.b0[b] = z[b][0] * wet[b] * c.globalGain;
+			c.b1[b] = z[b][1] * wet[b] * c.globalGain;
+			c.b2[b] = z[b][2] * wet[b] * c.globalGain;
+			c.a1[b] = p[b][1];
+			c.a2[b] = p[b][2];
 		}
-		return;
+		c.direct = dcGain * c.globalGain;
 	}
 
 	template <typename SampleType>
-	void lunchboxProcessor::processDeBess(SampleType** inputs, Vst::Sample64 getSampleRate, int32 sampleFrames) {
-		SampleType* in1 = inputs[0];
-		SampleType* in2 = inputs[1];
-
-		Vst::Sample64 tmp = 1.0; /*/ VuPPM /*/
+	void lunchboxProcessor::processEQ(SampleType** inputs, SampleType** outputs, Vst::Sample64 getSampleRate, int32 sampleFrames)
+	{
+		updateCoeffs(getSampleRate);
 
-		Vst::Sample64 overallscale = 1.0;
-		overallscale /= 44100.0;
-		overallscale *= getSampleRate;
+		// the 1.2kHz peak follows the smoothed Focus every kFocusUpdateStride samples while it ramps
+		int32 stride = smoothFocus.isSmoothing() ? kFocusUpdateStride : sampleFrames;
+		const Vst::Sample64* focus = smoothFocus.process(sampleFrames);
 
-		Vst::Sample64 intensity = pow(fParamIntensity, 5) * (8192 / overallscale);
-		Vst::Sample64 sharpness = fParamSharpness * 40.0;
-		if (sharpness < 2) sharpness = 2;
-		Vst::Sample64 speed = 0.1 / sharpness;
-		Vst::Sample64 depth = 1.0 / ((1.0 - fParamDepth) + 0.0001);
-		Vst::Sample64 iirAmount = 0.5; //Filter 
-		bool monitoring = bParamListen;
+		forEachGroup(inputs, outputs, [&](auto& group, SampleType** in, SampleType** out) {
+			using V = typename std::decay_t<decltype(group)>::Lanes;
+			for (int32 pos = 0; pos < sampleFrames; pos += stride)
+			{
+				int32 chunkEnd = (sampleFrames - pos < stride) ? sampleFrames : pos + stride;
+				setPeakCoeffs(focus[pos]);
 
-		while (--sampleFrames >= 0)
-		{
-			Vst::Sample64 inputSampleL = *in1;
-			Vst::Sample64 inputSampleR = *in2;
-
-			Vst::Sample64 drySampleL = inputSampleL;
-			Vst::Sample64 drySampleR = inputSampleR;
-
-			sL[0] = inputSampleL; //set up so both [0] and [1] will be input sample
-			sR[0] = inputSampleR; //set up so both [0] and [1] will be input sample
-			//we only use the [1] so this is just where samples come in
-			for (int x = sharpness; x > 0; x--) {
-				sL[x] = sL[x - 1];
-				sR[x] = sR[x - 1];
-			} //building up a set of slews
-
-			mL[1] = (sL[1] - sL[2]) * ((sL[1] - sL[2]) / 1.3);
-			mR[1] = (sR[1] - sR[2]) * ((sR[1] - sR[2]) / 1.3);
-			for (int x = sharpness - 1; x > 1; x--) {
-				mL[x] = (sL[x] - sL[x + 1]) * ((sL[x - 1] - sL[x]) / 1.3);
-				mR[x] = (sR[x] - sR[x + 1]) * ((sR[x - 1] - sR[x]) / 1.3);
-			} //building up a set of slews of slews
-
-			Vst::Sample64 senseL = fabs(mL[1] - mL[2]) * sharpness * sharpness;
-			Vst::Sample64 senseR = fabs(mR[1] - mR[2]) * sharpness * sharpness;
-			for (int x = sharpness - 1; x > 0; x--) {
-				Vst::Sample64 multL = fabs(mL[x] - mL[x + 1]) * sharpness * sharpness;
-				if (multL < 1.0) senseL *= multL;
-				Vst::Sample64 multR = fabs(mR[x] - mR[x + 1]) * sharpness * sharpness;
-				if (multR < 1.0) senseR *= multR;
-			} //sense is slews of slews times each other
-
-			senseL = 1.0 + (intensity * intensity * senseL);
-			if (senseL > intensity) { senseL = intensity; }
-			senseR = 1.0 + (intensity * intensity * senseR);
-			if (senseR > intensity) { senseR = intensity; }
-
-			if (flip_DeBess) {
-				iirSampleAL = (iirSampleAL * (1 - iirAmount)) + (inputSampleL * iirAmount);
-				iirSampleAR = (iirSampleAR * (1 - iirAmount)) + (inputSampleR * iirAmount);
-				ratioAL = (ratioAL * (1.0 - speed)) + (senseL * speed);
-				ratioAR = (ratioAR * (1.0 - speed)) + (senseR * speed);
-				if (ratioAL > depth) ratioAL = depth;
-				if (ratioAR > depth) ratioAR = depth;
-				if (ratioAL > 1.0) inputSampleL = iirSampleAL + ((inputSampleL - iirSampleAL) / ratioAL);
-				if (ratioAR > 1.0) inputSampleR = iirSampleAR + ((inputSampleR - iirSampleAR) / ratioAR);
-			}
-			else {
-				iirSampleBL = (iirSampleBL * (1 - iirAmount)) + (inputSampleL * iirAmount);
-				iirSampleBR = (iirSampleBR * (1 - iirAmount)) + (inputSampleR * iirAmount);
-				ratioBL = (ratioBL * (1.0 - speed)) + (senseL * speed);
-				ratioBR = (ratioBR * (1.0 - speed)) + (senseR * speed);
-				if (ratioBL > depth) ratioBL = depth;
-				if (ratioBR > depth) ratioBR = depth;
-				if (ratioAL > 1.0) inputSampleL = iirSampleBL + ((inputSampleL - iirSampleBL) / ratioBL);
-				if (ratioAR > 1.0) inputSampleR = iirSampleBR + ((inputSampleR - iirSampleBR) / ratioBR);
+				for (int32 n = pos; n < chunkEnd; n++)
+				{
+					V inputSample = loadFrame<V>(in, n);
+					tickEQ(group.eq, inputSample, eqCoeffs);
+					storeFrame(inputSample, out, n);
+				}
 			}
-			flip_DeBess = !flip_DeBess;
-
-			if (tmp > (inputSampleL / drySampleL)) tmp = (inputSampleL / drySampleL);
-			if (tmp > (inputSampleR / drySampleR)) tmp = (inputSampleR / drySampleR);
+		});
+	}
 
-			if (monitoring) {
-				inputSampleL = drySampleL - inputSampleL;
-				inputSampleR = drySampleR - inputSampleR;
-			}
-			//sense monitoring
+	//------------------------------------------------------------------------
+	void lunchboxProcessor::prepareDeBess(Vst::Sample64 getSampleRate, DeBessCoeffs& c)
+	{
+		Vst::Sample64 overallscale = 1.0;
+		overallscale /= 44100.0;
+		overallscale *= getSampleRate;
 
-			*in1 = inputSampleL;
-			*in2 = inputSampleR;
+		c.intensity = pow(fParamIntensity, 5) * (8192 / overallscale);
+		c.sharpness = fParamSharpness * 40.0;
+		if (c.sharpness < 2) c.sharpness = 2;
+		// the ratio's release and the filter keep their time constants; the
+		// sharpness is a length in samples of the slews, not a time
+		c.speed = rescaleOnePole(0.1 / c.sharpness, getSampleRate);
+		c.depth = 1.0 / ((1.0 - fParamDepth) + 0.0001);
+		c.iirAmount = rescaleOnePole(0.5, getSampleRate); //Filter
+		c.linkAmount = onePoleCoefficient(kDeBessLinkMs, getSampleRate);
+		c.monitoring = bParamListen;
+	}
 
-			in1++;
-			in2++;
+	inline void lunchboxProcessor::tickDeBessGroup(ChannelGroup<Double2>& group, Double2& inputSample, const DeBessCoeffs& c, Vst::Sample64& tmp)
+	{
+		switch (iParamDetect) {
+		case kDetectLinked:		tickDeBessLinked(group.deBess, group.deBessLink, inputSample, c, false, tmp);	break;
+		case kDetectMonoSum:	tickDeBessLinked(group.deBess, group.deBessLink, inputSample, c, true, tmp);	break;
+		case kDetectMidSide:
+			inputSample = encodeMidSide(inputSample);
+			tickDeBess(group.deBess, inputSample, c, tmp);
+			inputSample = decodeMidSide(inputSample);
+			break;
+		default:				tickDeBess(group.deBess, inputSample, c, tmp);	break;
 		}
-		fParamDeEssVuPPM = VuPPMconvert(tmp, -12.0, 0.0, -6.0);
-		return;
+	}
+
+	inline void lunchboxProcessor::tickDeBessGroup(ChannelGroup<Double1>& group, Double1& inputSample, const DeBessCoeffs& c, Vst::Sample64& tmp)
+	{
+		tickDeBess(group.deBess, inputSample, c, tmp);
 	}
 
 	template <typename SampleType>
-	void lunchboxProcessor::processComp(SampleType** inputs, Vst::Sample64 getSampleRate, int32 sampleFrames)
+	void lunchboxProcessor::processDeBess(SampleType** inputs, SampleType** outputs, Vst::Sample64 getSampleRate, int32 sampleFrames)
 	{
-		SampleType* in1 = inputs[0];
-		SampleType* in2 = inputs[1];
+		Vst::Sample64 tmp = 1.0; // meter
 
-		Vst::Sample64 tmp = 1.0; /*/ VuPPM /*/
+		updateCoeffs(getSampleRate);
+		const DeBessCoeffs& coeffs = deBessCoeffs;
+
+		forEachGroup(inputs, outputs, [&](auto& group, SampleType** in, SampleType** out) {
+			using V = typename std::decay_t<decltype(group)>::Lanes;
+			for (int32 n = 0; n < sampleFrames; n++)
+			{
+				V inputSample = loadFrame<V>(in, n);
+				tickDeBessGroup(group, inputSample, coeffs, tmp);
+				storeFrame(inputSample, out, n);
+			}
+		});
+		meterSums.deEssGain = std::min(meterSums.deEssGain, tmp);
+	}
 
+	//------------------------------------------------------------------------
+	void lunchboxProcessor::prepareComp(Vst::Sample64 getSampleRate, CompCoeffs& c)
+	{
+		// the speeds as they are at kTimingReferenceRate, then fitted to this one
 		Vst::Sample64 overallscale = 2.0;
 		overallscale /= 44100.0;
-		overallscale *= getSampleRate;
+		overallscale *= kTimingReferenceRate;
 
-		Vst::Sample64 threshold = 1.001 - (1.0 - pow(1.0 - fParamComp, 3));
-		Vst::Sample64 muMakeupGain = sqrt(1.0 / threshold);
+		c.threshold = 1.001 - (1.0 - pow(1.0 - fParamComp, 3));
+		Vst::Sample64 muMakeupGain = sqrt(1.0 / c.threshold);
 		muMakeupGain = (muMakeupGain + sqrt(muMakeupGain)) / 2.0;
 		muMakeupGain = sqrt(muMakeupGain);
 		Vst::Sample64 outGain = sqrt(muMakeupGain);
 		//gain settings around threshold
-		Vst::Sample64 release = pow((1.15 - fParamSpeed), 5) * 32768.0;
-		release /= overallscale;
+		c.release = pow((1.15 - fParamSpeed), 5) * 32768.0;
+		c.release /= overallscale;
 		// Vst::Sample64 fastest = sqrt(release);
-		Vst::Sample64 fastest = sqrt(release);
+		c.fastest = sqrt(c.release);
 		//speed settings around release
-		Vst::Sample64 coefficient;
-		Vst::Sample64 squaredSampleL;
-		Vst::Sample64 squaredSampleR;
-
-		// µ µ µ µ µ µ µ µ µ µ µ µ is the kitten song o/~
+		c.attack = bParamAttack;
+
+		// per update muSpeed moves by (release * x^2 + fastest) / muSpeed - speedStep
+		// and the gain by 1 / muSpeed^2: for the same times in ms muSpeed^2
+		// grows with the rate, so muSpeed falls by one over its square root.
+		// The attack moves by 1 / (k * sqrt(muSpeed)).
+		double timeScale = getTimeScale(getSampleRate);
+		c.speedStep = 1.0 / sqrt(timeScale);
+		c.attackScale = (c.attack ? 2.0 : 5.0) * pow(timeScale, 0.75);
+
+		// the efficient engine: the times the vintage one has on quiet
+		// material, where muSpeed settles at fastest, the gain moves by
+		// 1 / fastest^2 back up and by 1 / (k * sqrt(fastest)) down, every
+		// other sample at kTimingReferenceRate
+		c.efficient = (iParamCompMode == kCompEfficient);
+		c.releaseCoeff = onePoleCoefficient(1000.0 * 2.0 * c.release / kTimingReferenceRate, getSampleRate);
+		c.attackCoeff = onePoleCoefficient(1000.0 * 2.0 * (c.attack ? 2.0 : 5.0) * sqrt(c.fastest) / kTimingReferenceRate, getSampleRate);
+
+		c.inputGain = exp(log(10.0) * (12.0) / 20.0);
+		c.outputGain = exp(log(10.0) * (-12.0) / 20.0);
+	}
 
-		while (--sampleFrames >= 0)
-		{
-			Vst::Sample64 inputSampleL = *in1;
-			Vst::Sample64 inputSampleR = *in2;
+	inline void lunchboxProcessor::tickCompGroup(ChannelGroup<Double2>& group, Double2& inputSample, Double2 key, const CompCoeffs& c, Vst::Sample64& tmp)
+	{
+		switch (iParamDetect) {
+		case kDetectLinked:		tickCompLinked(group.compLink, inputSample, key, c, false, tmp);	break;
+		case kDetectMonoSum:	tickCompLinked(group.compLink, inputSample, key, c, true, tmp);	break;
+		case kDetectMidSide:
+			inputSample = encodeMidSide(inputSample);
+			tickComp(group.comp, inputSample, encodeMidSide(key), c, tmp);
+			inputSample = decodeMidSide(inputSample);
+			break;
+		default:				tickComp(group.comp, inputSample, key, c, tmp);	break;
+		}
+	}
 
-			Vst::Sample64 drySampleL = inputSampleL;
-			Vst::Sample64 drySampleR = inputSampleR;
+	inline void lunchboxProcessor::tickCompGroup(ChannelGroup<Double1>& group, Double1& inputSample, Double1 key, const CompCoeffs& c, Vst::Sample64& tmp)
+	{
+		tickComp(group.comp, inputSample, key, c, tmp);
+	}
 
-			inputSampleL *= exp(log(10.0) * (12.0) / 20.0);
-			inputSampleR *= exp(log(10.0) * (12.0) / 20.0);
+	inline void lunchboxProcessor::compEfficientGroup(ChannelGroup<Double2>& group, Double2* block, Double2* key, int32 frames, const CompCoeffs& c, Vst::Sample64& tmp)
+	{
+		switch (iParamDetect) {
+		case kDetectLinked:		compEfficientLinkedBlock(group.compLink, block, key, frames, c, false, tmp);	break;
+		case kDetectMonoSum:	compEfficientLinkedBlock(group.compLink, block, key, frames, c, true, tmp);	break;
+		case kDetectMidSide: {
+			// a sidechain is heard in mid and side too
+			if (key != block)
+				for (int32 n = 0; n < frames; n++) key[n] = encodeMidSide(key[n]);
+			for (int32 n = 0; n < frames; n++) block[n] = encodeMidSide(block[n]);
+			compEfficientBlock(group.comp, block, key, frames, c, tmp);
+			for (int32 n = 0; n < frames; n++) block[n] = decodeMidSide(block[n]);
+			break;
+		}
+		default:				compEfficientBlock(group.comp, block, key, frames, c, tmp);	break;
+		}
+	}
 
-			if (fabs(inputSampleL) > fabs(previousL)) squaredSampleL = previousL * previousL;
-			else squaredSampleL = inputSampleL * inputSampleL;
-			previousL = inputSampleL;
-			// inputSampleL *= muMakeupGain;
+	inline void lunchboxProcessor::compEfficientGroup(ChannelGroup<Double1>& group, Double1* block, Double1* key, int32 frames, const CompCoeffs& c, Vst::Sample64& tmp)
+	{
+		compEfficientBlock(group.comp, block, key, frames, c, tmp);
+	}
 
-			if (fabs(inputSampleR) > fabs(previousR)) squaredSampleR = previousR * previousR;
-			else squaredSampleR = inputSampleR * inputSampleR;
-			previousR = inputSampleR;
-			// inputSampleR *= muMakeupGain;
+	template <typename V>
+	inline void lunchboxProcessor::processCompBlock(ChannelGroup<V>& group, V* block, V* key, int32 frames, const CompCoeffs& c, Vst::Sample64& tmp)
+	{
+		if (c.efficient) {
+			compEfficientGroup(group, block, key ? key : block, frames, c, tmp);
+			return;
+		}
+		if (key)
+			for (int32 n = 0; n < frames; n++) tickCompGroup(group, block[n], key[n], c, tmp);
+		else
+			for (int32 n = 0; n < frames; n++) tickCompGroup(group, block[n], block[n], c, tmp);
+	}
 
-			//adjust coefficients for L
-			if (flip_MeowMu)
-			{
-				if (fabs(squaredSampleL) > threshold)
-				{
-					muVaryL = threshold / fabs(squaredSampleL);
-					muAttackL = sqrt(fabs(muSpeedAL));
-					if (bParamAttack) muAttackL *= 2.0;
-					else muAttackL *= 5.0;
-					muCoefficientAL = muCoefficientAL * (muAttackL - 1.0);
-					if (muVaryL < threshold)
-					{
-						muCoefficientAL = muCoefficientAL + threshold;
-					}
-					else
-					{
-						muCoefficientAL = muCoefficientAL + muVaryL;
-					}
-					muCoefficientAL = muCoefficientAL / muAttackL;
-				}
-				else
-				{
-					muCoefficientAL = muCoefficientAL * ((muSpeedAL * muSpeedAL) - 1.0);
-					muCoefficientAL = muCoefficientAL + 1.0;
-					muCoefficientAL = muCoefficientAL / (muSpeedAL * muSpeedAL);
-				}
-				muNewSpeedL = muSpeedAL * (muSpeedAL - 1);
-				muNewSpeedL = muNewSpeedL + fabs(squaredSampleL * release) + fastest;
-				muSpeedAL = muNewSpeedL / muSpeedAL;
-			}
-			else
-			{
-				if (fabs(squaredSampleL) > threshold)
-				{
-					muVaryL = threshold / fabs(squaredSampleL);
-					muAttackL = sqrt(fabs(muSpeedBL));
-					if (bParamAttack) muAttackL *= 2.0;
-					else muAttackL *= 5.0;
-					muCoefficientBL = muCoefficientBL * (muAttackL - 1);
-					if (muVaryL < threshold)
-					{
-						muCoefficientBL = muCoefficientBL + threshold;
-					}
-					else
-					{
-						muCoefficientBL = muCoefficientBL + muVaryL;
-					}
-					muCoefficientBL = muCoefficientBL / muAttackL;
-				}
-				else
-				{
-					muCoefficientBL = muCoefficientBL * ((muSpeedBL * muSpeedBL) - 1.0);
-					muCoefficientBL = muCoefficientBL + 1.0;
-					muCoefficientBL = muCoefficientBL / (muSpeedBL * muSpeedBL);
-				}
-				muNewSpeedL = muSpeedBL * (muSpeedBL - 1);
-				muNewSpeedL = muNewSpeedL + fabs(squaredSampleL * release) + fastest;
-				muSpeedBL = muNewSpeedL / muSpeedBL;
-			}
-			//got coefficients, adjusted speeds for L
+	template <typename SampleType>
+	void lunchboxProcessor::processComp(SampleType** inputs, SampleType** outputs, Vst::Sample64 getSampleRate, int32 sampleFrames, SampleType** keys)
+	{
+		Vst::Sample64 tmp = 1.0; // meter
 
-			//adjust coefficients for R
-			if (flip_MeowMu)
-			{
-				if (fabs(squaredSampleR) > threshold)
-				{
-					muVaryR = threshold / fabs(squaredSampleR);
-					muAttackR = sqrt(fabs(muSpeedAR));
-					if (bParamAttack) muAttackR *= 2.0;
-					else muAttackR *= 5.0;
-					muCoefficientAR = muCoefficientAR * (muAttackR - 1.0);
-					if (muVaryR < threshold)
-					{
-						muCoefficientAR = muCoefficientAR + threshold;
-					}
-					else
-					{
-						muCoefficientAR = muCoefficientAR + muVaryR;
-					}
-					muCoefficientAR = muCoefficientAR / muAttackR;
-				}
-				else
-				{
-					muCoefficientAR = muCoefficientAR * ((muSpeedAR * muSpeedAR) - 1.0);
-					muCoefficientAR = muCoefficientAR + 1.0;
-					muCoefficientAR = muCoefficientAR / (muSpeedAR * muSpeedAR);
-				}
-				muNewSpeedR = muSpeedAR * (muSpeedAR - 1);
-				muNewSpeedR = muNewSpeedR + fabs(squaredSampleR * release) + fastest;
-				muSpeedAR = muNewSpeedR / muSpeedAR;
-			}
-			else
-			{
-				if (fabs(squaredSampleR) > threshold)
-				{
-					muVaryR = threshold / fabs(squaredSampleR);
-					muAttackR = sqrt(fabs(muSpeedBR));
-					if (bParamAttack) muAttackR *= 2.0;
-					else muAttackR *= 5.0;
-					muCoefficientBR = muCoefficientBR * (muAttackR - 1);
-					if (muVaryR < threshold)
-					{
-						muCoefficientBR = muCoefficientBR + threshold;
-					}
-					else
-					{
-						muCoefficientBR = muCoefficientBR + muVaryR;
-					}
-					muCoefficientBR = muCoefficientBR / muAttackR;
-				}
-				else
-				{
-					muCoefficientBR = muCoefficientBR * ((muSpeedBR * muSpeedBR) - 1.0);
-					muCoefficientBR = muCoefficientBR + 1.0;
-					muCoefficientBR = muCoefficientBR / (muSpeedBR * muSpeedBR);
-				}
-				muNewSpeedR = muSpeedBR * (muSpeedBR - 1);
-				muNewSpeedR = muNewSpeedR + fabs(squaredSampleR * release) + fastest;
-				muSpeedBR = muNewSpeedR / muSpeedBR;
-			}
-			//got coefficients, adjusted speeds for R
+		updateCoeffs(getSampleRate);
+		const CompCoeffs& coeffs = compCoeffs;
 
-			if (flip_MeowMu)
-			{
-				coefficient = (muCoefficientAL + pow(muCoefficientAL, 2)) / 2.0;
-				inputSampleL *= coefficient;
-				coefficient = (muCoefficientAR + pow(muCoefficientAR, 2)) / 2.0;
-				inputSampleR *= coefficient;
-			}
-			else
+		forEachGroup(inputs, outputs, keys, [&](auto& group, SampleType** in, SampleType** out, SampleType** key) {
+			using V = typename std::decay_t<decltype(group)>::Lanes;
+			V block[kCompBlock];
+			V keyBlock[kCompBlock];
+			for (int32 pos = 0; pos < sampleFrames; pos += kCompBlock)
 			{
-				coefficient = (muCoefficientBL + pow(muCoefficientBL, 2)) / 2.0;
-				inputSampleL *= coefficient;
-				coefficient = (muCoefficientBR + pow(muCoefficientBR, 2)) / 2.0;
-				inputSampleR *= coefficient;
+				int32 frames = std::min(sampleFrames - pos, (int32)kCompBlock);
+				for (int32 n = 0; n < frames; n++) block[n] = loadFrame<V>(in, pos + n);
+				if (key)
+					for (int32 n = 0; n < frames; n++) keyBlock[n] = tickKeyDelay(group.compKey, loadFrame<V>(key, pos + n), compKeyDelay);
+				processCompBlock(group, block, key ? keyBlock : nullptr, frames, coeffs, tmp);
+				for (int32 n = 0; n < frames; n++) storeFrame(block[n], out, pos + n);
 			}
-			//applied compression with vari-vari-µ-µ-µ-µ-µ-µ-is-the-kitten-song o/~
-			//applied gain correction to control output level- tends to constrain sound rather than inflate it
-			flip_MeowMu = !flip_MeowMu;
-
-			inputSampleL *= exp(log(10.0) * (-12.0) / 20.0);
-			inputSampleR *= exp(log(10.0) * (-12.0) / 20.0);
-
-			if (tmp > (inputSampleL / drySampleL)) tmp = (inputSampleL / drySampleL);
-			if (tmp > (inputSampleR / drySampleR)) tmp = (inputSampleR / drySampleR);
-			if (inputSampleL == drySampleL) tmp = 1.0;
-			if (inputSampleR == drySampleR) tmp = 1.0;
-
-			*in1 = inputSampleL;
-			*in2 = inputSampleR;
-
-			in1++;
-			in2++;
-		}
-		fParamCompVuPPM = VuPPMconvert(tmp, -12.0, 0.0, -6.0);
-		return;
+		});
+		meterSums.compGain = std::min(meterSums.compGain, tmp);
 	}
 
-
-	template <typename SampleType>
-	void lunchboxProcessor::processGate(SampleType** inputs, Vst::Sample64 getSampleRate, int32 sampleFrames)
+	//------------------------------------------------------------------------
+	void lunchboxProcessor::prepareGate(Vst::Sample64 getSampleRate, GateCoeffs& c)
 	{
-		SampleType* in1 = inputs[0];
-		SampleType* in2 = inputs[1];
-
-		Vst::Sample64 overallscale = 1.0;
-		overallscale /= 44100.0;
-
 		//begin Gate
 		// double onthreshold = (pow(fParamGate, 3) / 3) + 0.00018;
 		Vst::Sample64 plainDB;
 		if (fParamGate > 0.5) plainDB = (2 * (0.0 + 18.0) * fParamGate) + (2 * -18.0);
 		else plainDB = (2 * (-18.0 - (-60.0)) * fParamGate) + (-60.0);
-		Vst::Sample64 onthreshold = exp(log(10.0) * plainDB / 20.0);
+		c.onthreshold = exp(log(10.0) * plainDB / 20.0);
 
-		Vst::Sample64 offthreshold = onthreshold * 1.1;
-		Vst::Sample64 release = 0.028331119964586;
-		Vst::Sample64 absmax = 220.9;
-		//speed to be compensated w.r.t sample rate
+		c.offthreshold = c.onthreshold * 1.1;
+		c.release = 0.028331119964586;	// 0.74 ms to close
+		c.absmax = 220.9;				// 4.6 ms of hold
 		//end Gate
 
-		while (--sampleFrames >= 0)
-		{
-			Vst::Sample64 inputSampleL = *in1;
-			Vst::Sample64 inputSampleR = *in2;
+		// both count samples at kTimingReferenceRate, whatever the host rate
+		// and the oversampling
+		c.step = 1.0 / (getTimeScale(getSampleRate) * oversampler.getFactor());
+		c.release *= c.step;
 
-			//begin Gate
-			if (inputSampleL > 0.0)
-			{
-				if (WasNegativeL == true) ZeroCrossL = absmax * 0.3;
-				WasNegativeL = false;
-			}
-			else {
-				ZeroCrossL += 1; WasNegativeL = true;
-			}
-
-			if (inputSampleR > 0.0)
-			{
-				if (WasNegativeR == true) ZeroCrossR = absmax * 0.3;
-				WasNegativeR = false;
-			}
-			else {
-				ZeroCrossR += 1; WasNegativeR = true;
-			}
-
-			if (ZeroCrossL > absmax) ZeroCrossL = absmax;
-			if (ZeroCrossR > absmax) ZeroCrossR = absmax;
+		c.precise = preciseMath;
+	}
 
-			if (gateL == 0.0)
-			{
-				//if gate is totally silent
-				if (fabs(inputSampleL) > onthreshold)
+	template <typename SampleType>
+	void lunchboxProcessor::processGate(SampleType** inputs, SampleType** outputs, Vst::Sample64 getSampleRate, int32 sampleFrames, SampleType** keys)
+	{
+		updateCoeffs(getSampleRate);
+		const GateCoeffs& coeffs = gateCoeffs;
+
+		forEachGroup(inputs, outputs, keys, [&](auto& group, SampleType** in, SampleType** out, SampleType** key) {
+			using V = typename std::decay_t<decltype(group)>::Lanes;
+			V gateOpen = 0.0;
+			if (key) {
+				// oversampled, the gate hears each key sample for all of its sub-samples
+				for (int32 n = 0; n < sampleFrames; n++)
 				{
-					if (gaterollerL == 0.0) gaterollerL = ZeroCrossL;
-					else gaterollerL -= release;
-					// trigger from total silence only- if we're active then signal must clear offthreshold
+					V inputSample = loadFrame<V>(in, n);
+					V keySample = tickKeyDelay(group.gateKey, loadFrame<V>(key, n), gateKeyDelay);
+					tickOversampled(group.overGate, oversampler, inputSample, [&](V& sample) {
+						tickGate(group.gate, sample, keySample, coeffs);
+						gateOpen = select(group.gate.gate > gateOpen, group.gate.gate, gateOpen);
+					});
+					storeFrame(inputSample, out, n);
 				}
-				else gaterollerL -= release;
 			}
 			else {
-				//gate is not silent but closing
-				if (fabs(inputSampleL) > offthreshold)
+				for (int32 n = 0; n < sampleFrames; n++)
 				{
-					if (gaterollerL < ZeroCrossL) gaterollerL = ZeroCrossL;
-					else gaterollerL -= release;
-					//always trigger if gate is over offthreshold, otherwise close anyway
+					V inputSample = loadFrame<V>(in, n);
+					tickOversampled(group.overGate, oversampler, inputSample, [&](V& sample) {
+						tickGate(group.gate, sample, coeffs);
+						gateOpen = select(group.gate.gate > gateOpen, group.gate.gate, gateOpen);
+					});
+					storeFrame(inputSample, out, n);
 				}
-				else gaterollerL -= release;
 			}
+			trackGate(group, gateOpen, sampleFrames);
+		});
+	}
+
+	//------------------------------------------------------------------------
+	void lunchboxProcessor::prepareInflator(InflatorCoeffs& c)
+	{
+		Vst::Sample64 curvepct = 0.5 - 0.5;
+		c.curveA = 1.5 + curvepct;			// 1 + (curve + 50) / 100
+		c.curveB = -(curvepct + curvepct);	// - curve / 50
+		c.curveC = curvepct - 0.5;			// (curve - 50) / 100
+		c.curveD = 0.0625 - curvepct * 0.25 + (curvepct * curvepct) * 0.25;	// 1 / 16 - curve / 400 + curve ^ 2 / (4 * 10 ^ 4)
+		c.safe = bParamSafe;
+	}
 
-			if (gateR == 0.0)
+	template <typename SampleType>
+	void lunchboxProcessor::processInflator(SampleType** inputs, SampleType** outputs, Vst::Sample64 getSampleRate, int32 sampleFrames)
+	{
+		updateCoeffs(getSampleRate);
+		const InflatorCoeffs& coeffs = inflatorCoeffs;
+		const Vst::Sample64* inflate = smoothInflate.process(sampleFrames);
+
+		forEachGroup(inputs, outputs, [&](auto& group, SampleType** in, SampleType** out) {
+			using V = typename std::decay_t<decltype(group)>::Lanes;
+			for (int32 n = 0; n < sampleFrames; n++)
 			{
-				//if gate is totally silent
-				if (fabs(inputSampleR) > onthreshold)
-				{
-					if (gaterollerR == 0.0) gaterollerR = ZeroCrossR;
-					else gaterollerR -= release;
-					// trigger from total silence only- if we're active then signal must clear offthreshold
-				}
-				else gaterollerR -= release;
-			}
-			else {
-				//gate is not silent but closing
-				if (fabs(inputSampleR) > offthreshold)
-				{
-					if (gaterollerR < ZeroCrossR) gaterollerR = ZeroCrossR;
-					else gaterollerR -= release;
-					//always trigger if gate is over offthreshold, otherwise close anyway
-				}
-				else gaterollerR -= release;
+				V inputSample = loadFrame<V>(in, n);
+				tickOversampled(group.overInflator, oversampler, inputSample, [&](V& sample) {
+					tickInflator(sample, coeffs, inflate[n]);
+				});
+				storeFrame(inputSample, out, n);
 			}
+		});
+	}
+
+	//------------------------------------------------------------------------
+	void lunchboxProcessor::prepareLimiter(Vst::Sample64 getSampleRate, LimiterCoeffs& c)
+	{
+		c.lookahead = getLimiterLookahead(getSampleRate);
+		c.ceiling = exp(log(10.0) * limiterCeilingDb / 20.0);
+		c.release = onePoleCoefficient(kLimiterReleaseMs, getSampleRate);
+		c.linked = (iParamDetect != kDetectStereo);
+	}
 
-			if (gaterollerL < 0.0) gaterollerL = 0.0;
-			if (gaterollerR < 0.0) gaterollerR = 0.0;
+	template <typename SampleType>
+	void lunchboxProcessor::processLimiter(SampleType** inputs, SampleType** outputs, Vst::Sample64 getSampleRate, int32 sampleFrames)
+	{
+		updateCoeffs(getSampleRate);
+		const LimiterCoeffs& coeffs = limiterCoeffs;
 
-			if (gaterollerL < 1.0)
+		forEachGroup(inputs, outputs, [&](auto& group, SampleType** in, SampleType** out) {
+			using V = typename std::decay_t<decltype(group)>::Lanes;
+			for (int32 n = 0; n < sampleFrames; n++)
 			{
-				gateL = gaterollerL;
-				double bridgerectifier = 1 - cos(fabs(inputSampleL));
-				if (inputSampleL > 0) inputSampleL = (inputSampleL * gateL) + (bridgerectifier * (1.0 - gateL));
-				else inputSampleL = (inputSampleL * gateL) - (bridgerectifier * (1.0 - gateL));
-				if (gateL == 0.0) inputSampleL = 0.0;
+				V inputSample = loadFrame<V>(in, n);
+				tickLimiter(group.limiter, inputSample, coeffs);
+				storeFrame(inputSample, out, n);
 			}
-			else gateL = 1.0;
+		});
+	}
+
+	//------------------------------------------------------------------------
+	template <typename SampleType>
+	void lunchboxProcessor::processInput(SampleType** inputs, SampleType** outputs, Vst::Sample64 getSampleRate, int32 sampleFrames)
+	{
+		const Vst::Sample64* In_db = smoothInput.process(sampleFrames);
 
-			if (gaterollerR < 1.0)
+		forEachGroup(inputs, outputs, [&](auto& group, SampleType** in, SampleType** out) {
+			using V = typename std::decay_t<decltype(group)>::Lanes;
+			V peak = 0.0;
+			V squares = 0.0;
+			for (int32 n = 0; n < sampleFrames; n++)
 			{
-				gateR = gaterollerR;
-				double bridgerectifier = 1 - cos(fabs(inputSampleR));
-				if (inputSampleR > 0) inputSampleR = (inputSampleR * gateR) + (bridgerectifier * (1.0 - gateR));
-				else inputSampleR = (inputSampleR * gateR) - (bridgerectifier * (1.0 - gateR));
-				if (gateR == 0.0) inputSampleR = 0.0;
+				V inputSample = loadFrame<V>(in, n);
+				tickInput(inputSample, In_db[n], peak, squares);
+				storeFrame(inputSample, out, n);
 			}
-			else gateR = 1.0;
-			//end Gate
-
-			*in1 = inputSampleL;
-			*in2 = inputSampleR;
+			meterSums.inPeak = std::max(meterSums.inPeak, maxOfLanes(peak));
+			meterSums.inSquares += sumOfLanes(squares);
+		});
+	}
 
-			in1++;
-			in2++;
+	//------------------------------------------------------------------------
+	template <typename V>
+	inline void lunchboxProcessor::tickOutput(V& inputSample, Vst::Sample64 gain, int32 precision, uint32* fpd)
+	{
+		inputSample = inputSample * gain;
+
+		if (precision == 0) {
+			//begin 32 bit floating point dither
+			double sample[V::kLanes];
+			inputSample.store(sample);
+			for (int i = 0; i < V::kLanes; i++) {
+				int expon; frexpf((float)sample[i], &expon);
+				fpd[i] ^= fpd[i] << 13; fpd[i] ^= fpd[i] >> 17; fpd[i] ^= fpd[i] << 5;
+				sample[i] += ldexp((double(fpd[i]) - uint32_t(0x7fffffff)) * 5.5e-36, expon + 62);
+			}
+			inputSample = V::load(sample);
+			//end 32 bit floating point dither
+		}
+		else {
+			//begin 64 bit floating point dither
+			for (int i = 0; i < V::kLanes; i++) {
+				//int expon; frexp((double)inputSample, &expon);
+				fpd[i] ^= fpd[i] << 13; fpd[i] ^= fpd[i] >> 17; fpd[i] ^= fpd[i] << 5;
+				//inputSample += ((double(fpd)-uint32_t(0x7fffffff)) * 1.1e-44l * pow(2,expon+62));
+			}
+			//end 64 bit floating point dither
 		}
 	}
 
-
 	template <typename SampleType>
-	void lunchboxProcessor::processInflator(SampleType** inputs, Vst::Sample64 getSampleRate, int32 sampleFrames)
+	void lunchboxProcessor::processOutput(SampleType** inputs, SampleType** outputs, Vst::Sample64 getSampleRate, int32 sampleFrames, int32 precision)
 	{
-		SampleType* in1 = (SampleType*)inputs[0];
-		SampleType* in2 = (SampleType*)inputs[1];
-
-		Vst::Sample64 curvepct = 0.5 - 0.5;
-		Vst::Sample64 curveA = 1.5 + curvepct;			// 1 + (curve + 50) / 100
-		Vst::Sample64 curveB = -(curvepct + curvepct);	// - curve / 50
-		Vst::Sample64 curveC = curvepct - 0.5;			// (curve - 50) / 100
-		Vst::Sample64 curveD = 0.0625 - curvepct * 0.25 + (curvepct * curvepct) * 0.25;	// 1 / 16 - curve / 400 + curve ^ 2 / (4 * 10 ^ 4)
+		const Vst::Sample64* Out_db = smoothOutput.process(sampleFrames);
 
-		Vst::Sample64 s1_L, s1_R;
-		Vst::Sample64 s2_L, s2_R;
-		Vst::Sample64 s3_L, s3_R;
-		Vst::Sample64 s4_L, s4_R;
-
-		Vst::Sample64 signL;
-		Vst::Sample64 signR;
-
-		while (--sampleFrames >= 0)
-		{
-			Vst::Sample64 inputSampleL = *in1;
-			Vst::Sample64 inputSampleR = *in2;
-			Vst::Sample64 drySampleL = inputSampleL;
-			Vst::Sample64 drySampleR = inputSampleR;
-
-			if (bParamSafe) {
-				if (inputSampleL > 1.0)
-					inputSampleL = 1.0;
-				else if (inputSampleL < -1.0)
-					inputSampleL = -1.0;
-
-				if (inputSampleR > 1.0)
-					inputSampleR = 1.0;
-				else if (inputSampleR < -1.0)
-					inputSampleR = -1.0;
+		forEachGroup(inputs, outputs, [&](auto& group, SampleType** in, SampleType** out) {
+			using V = typename std::decay_t<decltype(group)>::Lanes;
+			for (int32 n = 0; n < sampleFrames; n++)
+			{
+				V inputSample = loadFrame<V>(in, n);
+				tickOutput(inputSample, Out_db[n], precision, group.fpd);
+				storeFrame(inputSample, out, n);
 			}
+		});
+	}
 
-			if (inputSampleL > 0.0)
-				signL = 1.0;
-			else
-				signL = -1.0;
-
-			if (inputSampleR > 0.0)
-				signR = 1.0;
-			else
-				signR = -1.0;
-
-			s1_L = fabs(inputSampleL);
-			s2_L = s1_L * s1_L;
-			s3_L = s2_L * s1_L;
-			s4_L = s2_L * s2_L;
-
-			s1_R = fabs(inputSampleR);
-			s2_R = s1_R * s1_R;
-			s3_R = s2_R * s1_R;
-			s4_R = s2_R * s2_R;
-
-			if (s1_L >= 2.0)
-				inputSampleL = 0.0;
-			else if (s1_L > 1.0)
-				inputSampleL = (2.0 * s1_L) - s2_L;
-			else
-				inputSampleL = (curveA * s1_L) + (curveB * s2_L) + (curveC * s3_L) - (curveD * (s2_L - (2.0 * s3_L) + s4_L));
-
-			if (s1_R >= 2.0)
-				inputSampleR = 0.0;
-			else if (s1_R > 1.0)
-				inputSampleR = (2.0 * s1_R) - s2_R;
-			else
-				inputSampleR = (curveA * s1_R) + (curveB * s2_R) + (curveC * s3_R) - (curveD * (s2_R - (2.0 * s3_R) + s4_R));
-
-			inputSampleL *= signL;
-			inputSampleR *= signR;
-
-			if (fParamInflate != 1.0) {
-				inputSampleL = (drySampleL * (1.0 - fParamInflate)) + (inputSampleL * fParamInflate);
-				inputSampleR = (drySampleR * (1.0 - fParamInflate)) + (inputSampleR * fParamInflate);
+	//------------------------------------------------------------------------
+	template <typename SampleType>
+	void lunchboxProcessor::meterOutput(SampleType** outputs, int32 sampleFrames)
+	{
+		auto meter = [&](auto& group, SampleType** out) {
+			using V = typename std::decay_t<decltype(group)>::Lanes;
+			// a sleeping group's output is zero, its history too after a reset
+			if (group.sleeping && !bParamBypass) {
+				group.truePeak.reset();
+				group.kWeight.reset();
+				return;
 			}
 
-			if (bParamSafe) {
-				if (inputSampleL > 1.0)
-					inputSampleL = 1.0;
-				else if (inputSampleL < -1.0)
-					inputSampleL = -1.0;
-
-				if (inputSampleR > 1.0)
-					inputSampleR = 1.0;
-				else if (inputSampleR < -1.0)
-					inputSampleR = -1.0;
+			V peak = 0.0;
+			V squares = 0.0;
+			V truePeak = 0.0;
+			V weightedSquares = 0.0;
+			for (int32 n = 0; n < sampleFrames; n++)
+			{
+				V outputSample = loadFrame<V>(out, n);
+				V magnitude = absLanes(outputSample);
+				peak = select(magnitude > peak, magnitude, peak);
+				squares = squares + outputSample * outputSample;
+				V oversampled = tickTruePeak(group.truePeak, outputSample);
+				truePeak = select(oversampled > truePeak, oversampled, truePeak);
+				V weighted = tickKWeight(group.kWeight, kWeightCoeffs, outputSample);
+				weightedSquares = weightedSquares + weighted * weighted;
 			}
-
-			*in1 = inputSampleL;
-			*in2 = inputSampleR;
-
-			in1++;
-			in2++;
-		}
-		return;
+			meterSums.outPeak = std::max(meterSums.outPeak, maxOfLanes(peak));
+			meterSums.outSquares += sumOfLanes(squares);
+			meterSums.outTruePeak = std::max(meterSums.outTruePeak, maxOfLanes(truePeak));
+			meterSums.outWeighted += sumOfLanes(weightedSquares);
+		};
+		for (size_t g = 0; g < pairs.size(); g++) meter(pairs[g], outputs + 2 * g);
+		if (numChannels & 1) meter(single, outputs + numChannels - 1);
 	}
 
+	//------------------------------------------------------------------------
+	// Fused kernel
+	//------------------------------------------------------------------------
 	template <typename SampleType>
-	void lunchboxProcessor::processInput(SampleType** inputs, Vst::Sample64 getSampleRate, int32 sampleFrames)
+	void lunchboxProcessor::processFused(SampleType** inputs, SampleType** outputs, Vst::Sample64 getSampleRate, int32 sampleFrames, int32 precision, SampleType** compKeys, SampleType** gateKeys)
 	{
-		SampleType* in1 = (SampleType*)inputs[0];
-		SampleType* in2 = (SampleType*)inputs[1];
-		Vst::Sample64 In_db = norm_to_gain((Vst::Sample64)fParamInput);
-
-		Vst::Sample64 tmpIn = 0.0; /*/ VuPPM /*/
+		updateCoeffs(getSampleRate);
+
+		const Vst::Sample64* In_db = smoothInput.process(sampleFrames);
+		const Vst::Sample64* drive = smoothDrive.process(sampleFrames);
+		const Vst::Sample64* inflate = smoothInflate.process(sampleFrames);
+		const Vst::Sample64* Out_db = smoothOutput.process(sampleFrames);
+		int32 stride = smoothFocus.isSmoothing() ? kFocusUpdateStride : sampleFrames;
+		const Vst::Sample64* focus = smoothFocus.process(sampleFrames);
+
+		Vst::Sample64 tmpDeEss = 1.0; // meters
+		Vst::Sample64 tmpComp = 1.0;
+
+		// both are the sidechain or nullptr
+		const bool keyComp = (compKeys != nullptr);
+		const bool keyGate = (gateKeys != nullptr);
+		const bool output = outputStage;
+
+		forEachGroup(inputs, outputs, keyComp ? compKeys : gateKeys, [&](auto& state, SampleType** in, SampleType** out, SampleType** key) {
+			using V = typename std::decay_t<decltype(state)>::Lanes;
+			V peakIn = 0.0;
+			V squaresIn = 0.0;
+			V gateOpen = 0.0;
+
+			// keyed : whether the sidechain is read at all, so without it the
+			// loops are the ones they always were
+			auto run = [&](auto keyed) {
+				constexpr bool kKeyed = decltype(keyed)::value;
+
+				for (int32 pos = 0; pos < sampleFrames; pos += stride)
+				{
+					int32 chunkEnd = (sampleFrames - pos < stride) ? sampleFrames : pos + stride;
+					setPeakCoeffs(focus[pos]);
+
+					// MeowMu takes up to kCompBlock frames at a time, the stages before
+					// it fill them and the ones after it take them on
+					V block[kCompBlock];
+					V keyBlock[kCompBlock];
+					for (int32 blockPos = pos; blockPos < chunkEnd; blockPos += kCompBlock)
+					{
+						int32 frames = std::min(chunkEnd - blockPos, (int32)kCompBlock);
+
+						for (int32 i = 0; i < frames; i++)
+						{
+							const int32 n = blockPos + i;
+							V inputSample = loadFrame<V>(in, n);
+
+							// the stages hand over through SampleType buffers in the per-stage
+							// path, roundTo keeps that rounding so both paths match bit for bit
+							tickInput(inputSample, In_db[n], peakIn, squaresIn);
+							roundTo<SampleType>(inputSample);
+							tickOversampled(state.overChannel9, oversampler, inputSample, [&](V& sample) {
+								tickChannel9(state.channel9, sample, channel9Coeffs, drive[n]);
+							});
+							roundTo<SampleType>(inputSample);
+							tickEQ(state.eq, inputSample, eqCoeffs);
+							roundTo<SampleType>(inputSample);
+							tickDeBessGroup(state, inputSample, deBessCoeffs, tmpDeEss);
+							roundTo<SampleType>(inputSample);
+							block[i] = inputSample;
+							if constexpr (kKeyed)
+								if (keyComp) keyBlock[i] = tickKeyDelay(state.compKey, loadFrame<V>(key, n), compKeyDelay);
+						}
 
-		while (--sampleFrames >= 0)
-		{
-			Vst::Sample64 inputSampleL = *in1;
-			Vst::Sample64 inputSampleR = *in2;
-			inputSampleL *= In_db;
-			inputSampleR *= In_db;
-			if (inputSampleL > tmpIn) { tmpIn = inputSampleL; }
-			if (inputSampleR > tmpIn) { tmpIn = inputSampleR; }
-			if (fabs(inputSampleL) < 1.18e-23) inputSampleL = fpdL * 1.18e-17;
-			if (fabs(inputSampleR) < 1.18e-23) inputSampleR = fpdR * 1.18e-17;
-			*in1 = inputSampleL;
-			*in2 = inputSampleR;
-			in1++;
-			in2++;
-		}
+						processCompBlock(state, block, (kKeyed && keyComp) ? keyBlock : nullptr, frames, compCoeffs, tmpComp);
+
+						for (int32 i = 0; i < frames; i++)
+						{
+							const int32 n = blockPos + i;
+							V inputSample = block[i];
+							roundTo<SampleType>(inputSample);
+							tickOversampled(state.overInflator, oversampler, inputSample, [&](V& sample) {
+								tickInflator(sample, inflatorCoeffs, inflate[n]);
+							});
+							roundTo<SampleType>(inputSample);
+							if (bParamSafe) {
+								tickLimiter(state.limiter, inputSample, limiterCoeffs);
+								roundTo<SampleType>(inputSample);
+							}
+							if constexpr (kKeyed) {
+								if (keyGate) {
+									V keySample = tickKeyDelay(state.gateKey, loadFrame<V>(key, n), gateKeyDelay);
+									tickOversampled(state.overGate, oversampler, inputSample, [&](V& sample) {
+										tickGate(state.gate, sample, keySample, gateCoeffs);
+										gateOpen = select(state.gate.gate > gateOpen, state.gate.gate, gateOpen);
+									});
+								}
+								else {
+									tickOversampled(state.overGate, oversampler, inputSample, [&](V& sample) {
+										tickGate(state.gate, sample, gateCoeffs);
+										gateOpen = select(state.gate.gate > gateOpen, state.gate.gate, gateOpen);
+									});
+								}
+							}
+							else {
+								tickOversampled(state.overGate, oversampler, inputSample, [&](V& sample) {
+									tickGate(state.gate, sample, gateCoeffs);
+									gateOpen = select(state.gate.gate > gateOpen, state.gate.gate, gateOpen);
+								});
+							}
+							roundTo<SampleType>(inputSample);
+							if (output) tickOutput(inputSample, Out_db[n], precision, state.fpd);
+
+							storeFrame(inputSample, out, n);
+						}
+					}
+				}
+			};
+			if (key) run(std::true_type());
+			else run(std::false_type());
 
-		/*/ VuPPM /*/
-		fParamInVuPPM = VuPPMconvert(tmpIn, -60.0, 0.0, -18.0);
+			meterSums.inPeak = std::max(meterSums.inPeak, maxOfLanes(peakIn));
+			meterSums.inSquares += sumOfLanes(squaresIn);
+			trackGate(state, gateOpen, sampleFrames);
+		});
 
-		return;
+		meterSums.deEssGain = std::min(meterSums.deEssGain, tmpDeEss);
+		meterSums.compGain = std::min(meterSums.compGain, tmpComp);
 	}
 
 	template <typename SampleType>
-	void lunchboxProcessor::processOutput(SampleType** inputs, Vst::Sample64 getSampleRate, int32 sampleFrames, int32 precision)
+	void lunchboxProcessor::processBypass(SampleType** inputs, Vst::Sample64 getSampleRate, int32 sampleFrames) 
 	{
-		SampleType* in1 = (SampleType*)inputs[0];
-		SampleType* in2 = (SampleType*)inputs[1];
-		Vst::Sample64 Out_db = norm_to_gain((Vst::Sample64)fParamOutput);
-
-		Vst::Sample64 tmpOut = 0.0; /*/ VuPPM /*/
-
-		while (--sampleFrames >= 0)
+		// the input meter without the Input gain, the output one is metered
+		// from the copy in the outputs
+		for (int32 ch = 0; ch < numChannels; ch++)
 		{
-			Vst::Sample64 inputSampleL = *in1;
-			Vst::Sample64 inputSampleR = *in2;
-			inputSampleL *= Out_db;
-			inputSampleR *= Out_db;
-			if (inputSampleL > tmpOut) { tmpOut = inputSampleL; }
-			if (inputSampleR > tmpOut) { tmpOut = inputSampleR; }
-			if (precision == 0) {
-				//begin 32 bit stereo floating point dither
-				int expon; frexpf((float)inputSampleL, &expon);
-				fpdL ^= fpdL << 13; fpdL ^= fpdL >> 17; fpdL ^= fpdL << 5;
-				inputSampleL += ((double(fpdL) - uint32_t(0x7fffffff)) * 5.5e-36l * pow(2, expon + 62));
-				frexpf((float)inputSampleR, &expon);
-				fpdR ^= fpdR << 13; fpdR ^= fpdR >> 17; fpdR ^= fpdR << 5;
-				inputSampleR += ((double(fpdR) - uint32_t(0x7fffffff)) * 5.5e-36l * pow(2, expon + 62));
-				//end 32 bit stereo floating point dither
-			}
-			else {
-				//begin 64 bit stereo floating point dither
-				//int expon; frexp((double)inputSampleL, &expon);
-				fpdL ^= fpdL << 13; fpdL ^= fpdL >> 17; fpdL ^= fpdL << 5;
-				//inputSampleL += ((double(fpdL)-uint32_t(0x7fffffff)) * 1.1e-44l * pow(2,expon+62));
-				//frexp((double)inputSampleR, &expon);
-				fpdR ^= fpdR << 13; fpdR ^= fpdR >> 17; fpdR ^= fpdR << 5;
-				//inputSampleR += ((double(fpdR)-uint32_t(0x7fffffff)) * 1.1e-44l * pow(2,expon+62));
-				//end 64 bit stereo floating point dither
+			SampleType* in1 = inputs[ch];
+			int32 samples = sampleFrames;
+			while (--samples >= 0)
+			{
+				Vst::Sample64 inputSample = *in1;
+				meterSums.inPeak = std::max(meterSums.inPeak, fabs(inputSample));
+				meterSums.inSquares += inputSample * inputSample;
+				in1++;
 			}
-			*in1 = inputSampleL;
-			*in2 = inputSampleR;
-			in1++;
-			in2++;
 		}
 
-		/*/ VuPPM /*/
-		fParamOutVuPPM = VuPPMconvert(tmpOut, -60.0, 0.0, -18.0);
-
 		return;
 	}
 
-	template <typename SampleType>
-	void lunchboxProcessor::processBypass(SampleType** inputs, Vst::Sample64 getSampleRate, int32 sampleFrames) 
+	void lunchboxProcessor::setPeakCoeffs(Vst::Sample64 focus)
 	{
-		SampleType* in1 = (SampleType*)inputs[0];
-		SampleType* in2 = (SampleType*)inputs[1];
+		if (focus == peakFocus) return;
+		peakFocus = focus;
 
-		Vst::Sample64 tmpIn = 0.0; /*/ VuPPM /*/
-
-		int32 samples = sampleFrames;
-
-		while (--samples >= 0)
-		{
-			Vst::Sample64 inputSampleL = *in1;
-			Vst::Sample64 inputSampleR = *in2;
-			if (inputSampleL > tmpIn) { tmpIn = inputSampleL; }
-			if (inputSampleR > tmpIn) { tmpIn = inputSampleR; }
-			in1++;
-			in2++;
+		Vst::Sample64 peakGain = (12.0 * focus - 6.0);
+		Vst::Sample64 V_1k2 = pow(10, abs(peakGain) / 20);
+		Vst::Sample64 QK, VQK;
+		if (peakGain > 0.0) {
+			QK = 1 / Q_1k2 * K_1k2;
+			VQK = V_1k2 / Q_1k2 * K_1k2;
 		}
-
-		/*/ VuPPM /*/
-		fParamInVuPPM = VuPPMconvert(tmpIn, -60.0, 0.0, -18.0);
-		fParamOutVuPPM = fParamInVuPPM;
-
-		return;
+		else {
+			QK = V_1k2 / Q_1k2 * K_1k2;
+			VQK = 1 / Q_1k2 * K_1k2;
+		}
+		Vst::Sample64 norm_1k2 = 1 / (1 + QK + K_1k2_2);
+		eqCoeffs.z_1k2[0] = (1 + VQK + K_1k2_2) * norm_1k2;
+		eqCoeffs.z_1k2[1] = 2 * (K_1k2_2 - 1) * norm_1k2;
+		eqCoeffs.z_1k2[2] = (1 - VQK + K_1k2_2) * norm_1k2;
+		eqCoeffs.p_1k2[0] = 1.0;
+		eqCoeffs.p_1k2[1] = eqCoeffs.z_1k2[1];
+		eqCoeffs.p_1k2[2] = (1 - QK + K_1k2_2) * norm_1k2;
 	}
 
 	inline void lunchboxProcessor::setCoeffs(double Fs)
 	{
-		while (fpdL < 16386) fpdL = rand() * UINT32_MAX;
-		while (fpdR < 16386) fpdR = rand() * UINT32_MAX;
+		for (auto& group : pairs)
+			for (uint32& fpd : group.fpd) while (fpd < 16386) fpd = rand() * UINT32_MAX;
+		if (numChannels & 1)
+			while (single.fpd[0] < 16386) single.fpd[0] = rand() * UINT32_MAX;
 
 		double Fc, K, Q, norm;
 
@@ -1256,80 +1484,82 @@ namespace yg331 {
 		Fc = 10.0;
 		K = tan(M_PI * Fc / Fs);
 		norm = 1.0 / (1.0 + K / Q + K * K);
-		z_10[0] = K / Q * norm;
-		z_10[1] = 0.0;
-		z_10[2] = -z_10[0];
-		p_10[0] = 1.0;
-		p_10[1] = 2.0 * (K * K - 1.0) * norm;
-		p_10[2] = (1.0 - K / Q + K * K) * norm;
+		eqCoeffs.z_10[0] = K / Q * norm;
+		eqCoeffs.z_10[1] = 0.0;
+		eqCoeffs.z_10[2] = -eqCoeffs.z_10[0];
+		eqCoeffs.p_10[0] = 1.0;
+		eqCoeffs.p_10[1] = 2.0 * (K * K - 1.0) * norm;
+		eqCoeffs.p_10[2] = (1.0 - K / Q + K * K) * norm;
 
 		Fc = 40.0;
 		K = tan(M_PI * Fc / Fs);
 		norm = 1.0 / (1.0 + K / Q + K * K);
-		z_40[0] = K / Q * norm;
-		z_40[1] = 0.0;
-		z_40[2] = -z_40[0];
-		p_40[0] = 1.0;
-		p_40[1] = 2.0 * (K * K - 1.0) * norm;
-		p_40[2] = (1.0 - K / Q + K * K) * norm;
+		eqCoeffs.z_40[0] = K / Q * norm;
+		eqCoeffs.z_40[1] = 0.0;
+		eqCoeffs.z_40[2] = -eqCoeffs.z_40[0];
+		eqCoeffs.p_40[0] = 1.0;
+		eqCoeffs.p_40[1] = 2.0 * (K * K - 1.0) * norm;
+		eqCoeffs.p_40[2] = (1.0 - K / Q + K * K) * norm;
 
 		Fc = 160.0;
 		K = tan(M_PI * Fc / Fs);
 		norm = 1.0 / (1.0 + K / Q + K * K);
-		z_160[0] = K / Q * norm;
-		z_160[1] = 0.0;
-		z_160[2] = -z_160[0];
-		p_160[0] = 1.0;
-		p_160[1] = 2.0 * (K * K - 1.0) * norm;
-		p_160[2] = (1.0 - K / Q + K * K) * norm;
+		eqCoeffs.z_160[0] = K / Q * norm;
+		eqCoeffs.z_160[1] = 0.0;
+		eqCoeffs.z_160[2] = -eqCoeffs.z_160[0];
+		eqCoeffs.p_160[0] = 1.0;
+		eqCoeffs.p_160[1] = 2.0 * (K * K - 1.0) * norm;
+		eqCoeffs.p_160[2] = (1.0 - K / Q + K * K) * norm;
 
 		// 640Hz
 		Fc = 640.0;
 		K = tan(M_PI * Fc / Fs);
 		norm = 1.0 / (1.0 + K / Q + K * K);
-		z_640[0] = K / Q * norm;
-		z_640[1] = 0.0;
-		z_640[2] = -z_640[0];
-		p_640[0] = 1.0;
-		p_640[1] = 2.0 * (K * K - 1.0) * norm;
-		p_640[2] = (1.0 - K / Q + K * K) * norm;
+		eqCoeffs.z_640[0] = K / Q * norm;
+		eqCoeffs.z_640[1] = 0.0;
+		eqCoeffs.z_640[2] = -eqCoeffs.z_640[0];
+		eqCoeffs.p_640[0] = 1.0;
+		eqCoeffs.p_640[1] = 2.0 * (K * K - 1.0) * norm;
+		eqCoeffs.p_640[2] = (1.0 - K / Q + K * K) * norm;
 
 		// 1200Hz
 		Fc = 1200.0;
 		Q_1k2 = 1.5;
 		K_1k2 = tan(M_PI * Fc / Fs);
 		K_1k2_2 = K_1k2 * K_1k2;
+		peakFocus = -1.0;
 
 		// 2500Hz
 		Fc = 1200.0; // YES
 		K = tan(M_PI * Fc / Fs);
 		norm = 1.0 / (K + 1.0);
-		z_2k5[0] = norm;
-		z_2k5[1] = -norm;
-		z_2k5[2] = 0.0;
-		p_2k5[0] = 1.0;
-		p_2k5[1] = (K - 1) * norm;
-		p_2k5[2] = 0.0;
+		eqCoeffs.z_2k5[0] = norm;
+		eqCoeffs.z_2k5[1] = -norm;
+		eqCoeffs.z_2k5[2] = 0.0;
+		eqCoeffs.p_2k5[0] = 1.0;
+		eqCoeffs.p_2k5[1] = (K - 1) * norm;
+		eqCoeffs.p_2k5[2] = 0.0;
 
 		// 20000Hz
 		Fc = 10500.0; //YES
 		K = tan(M_PI * Fc / Fs);
 		norm = 1.0 / (K + 1.0);
-		z_20k[0] = norm;
-		z_20k[1] = -norm;
-		z_20k[2] = 0.0;
-		p_20k[0] = 1.0;
-		p_20k[1] = (K - 1) * norm;
-		p_20k[2] = 0.0;
+		eqCoeffs.z_20k[0] = norm;
+		eqCoeffs.z_20k[1] = -norm;
+		eqCoeffs.z_20k[2] = 0.0;
+		eqCoeffs.p_20k[0] = 1.0;
+		eqCoeffs.p_20k[1] = (K - 1) * norm;
+		eqCoeffs.p_20k[2] = 0.0;
 
 		for (int i = 0; i < 3; i++) {
-			z_10[i] *= 5.623413;
-			z_40[i] *= 5.623413;
-			z_160[i] *= 5.623413;
-			z_640[i] *= 5.623413;
-			z_2k5[i] *= 7.943282;
-			z_20k[i] *= 7.943282;
+			eqCoeffs.z_10[i] *= 5.623413;
+			eqCoeffs.z_40[i] *= 5.623413;
+			eqCoeffs.z_160[i] *= 5.623413;
+			eqCoeffs.z_640[i] *= 5.623413;
+			eqCoeffs.z_2k5[i] *= 7.943282;
+			eqCoeffs.z_20k[i] *= 7.943282;
 		}
+		dirtyCoeffs |= kDirtyEQ;
 	};
 
 
@@ -1358,6 +1588,21 @@ namespace yg331 {
 	{
 		//--- called before any processing ----
 		setCoeffs(newSetup.sampleRate);
+
+		smoothInput.setup(newSetup.sampleRate, newSetup.maxSamplesPerBlock, kSmoothingMs);
+		smoothOutput.setup(newSetup.sampleRate, newSetup.maxSamplesPerBlock, kSmoothingMs);
+		smoothDrive.setup(newSetup.sampleRate, newSetup.maxSamplesPerBlock, kSmoothingMs);
+		smoothFocus.setup(newSetup.sampleRate, newSetup.maxSamplesPerBlock, kSmoothingMs);
+		smoothInflate.setup(newSetup.sampleRate, newSetup.maxSamplesPerBlock, kSmoothingMs);
+		resetSmoothers();
+
+		meterFrameLength = std::max((int32)(newSetup.sampleRate * kMeterFrameMs * 0.001 + 0.5), kMinSubBlock);
+		kWeightCoeffs.prepare(newSetup.sampleRate);
+
+		// the coefficients, and with them the tail, for the new rate before
+		// the host asks for it
+		updateCoeffs(newSetup.sampleRate);
+
 		return AudioEffect::setupProcessing(newSetup);
 	}
 
@@ -1482,7 +1727,35 @@ namespace yg331 {
 			return kResultFalse;
 		bParamBypass = savedBypass;
 
+		// appended later, older states end here
+		int32 savedDetect = DetectInit;
+		if (streamer.readInt32(savedDetect) == false)
+			savedDetect = DetectInit;
+		savedDetect = std::max(0, std::min(savedDetect, (int32)kNumDetectModes - 1));
+		iParamDetect = savedDetect;
+
+		int32 savedOversampling = OversamplingInit;
+		if (streamer.readInt32(savedOversampling) == false)
+			savedOversampling = OversamplingInit;
+		iParamOversampling = std::max(0, std::min(savedOversampling, (int32)kNumOversamplings - 1));
 
+		int32 savedOversamplingFilter = OversamplingFilterInit;
+		if (streamer.readInt32(savedOversamplingFilter) == false)
+			savedOversamplingFilter = OversamplingFilterInit;
+		iParamOversamplingFilter = std::max(0, std::min(savedOversamplingFilter, (int32)kNumOversamplingFilters - 1));
+
+		int32 savedCompMode = CompModeInit;
+		if (streamer.readInt32(savedCompMode) == false)
+			savedCompMode = CompModeInit;
+		iParamCompMode = std::max(0, std::min(savedCompMode, (int32)kNumCompModes - 1));
+
+		int32 savedSidechain = SidechainInit;
+		if (streamer.readInt32(savedSidechain) == false)
+			savedSidechain = SidechainInit;
+		iParamSidechain = std::max(0, std::min(savedSidechain, (int32)kNumSidechainModes - 1));
+
+		// the coefficients, smoothers and latency follow on the audio thread
+		stateChanged.store(true, std::memory_order_release);
 
 
 		if (Vst::Helpers::isProjectState(state) == kResultTrue)
@@ -1539,10 +1812,36 @@ namespace yg331 {
 		streamer.writeInt32(bParamAttack ? 1 : 0);
 		streamer.writeInt32(bParamSafe ? 1 : 0);
 		streamer.writeInt32(bParamBypass ? 1 : 0);
+		streamer.writeInt32(iParamDetect);
+		streamer.writeInt32(iParamOversampling);
+		streamer.writeInt32(iParamOversamplingFilter);
+		streamer.writeInt32(iParamCompMode);
+		streamer.writeInt32(iParamSidechain);
 
 
 		return kResultOk;
 	}
 
+	//------------------------------------------------------------------------
+	// The stages are also driven one by one from outside (benchmark), so
+	// both sample types are instantiated here.
+	//------------------------------------------------------------------------
+	template void lunchboxProcessor::processChannel9<Vst::Sample32>(Vst::Sample32**, Vst::Sample32**, Vst::Sample64, int32);
+	template void lunchboxProcessor::processChannel9<Vst::Sample64>(Vst::Sample64**, Vst::Sample64**, Vst::Sample64, int32);
+	template void lunchboxProcessor::processEQ<Vst::Sample32>(Vst::Sample32**, Vst::Sample32**, Vst::Sample64, int32);
+	template void lunchboxProcessor::processEQ<Vst::Sample64>(Vst::Sample64**, Vst::Sample64**, Vst::Sample64, int32);
+	template void lunchboxProcessor::processDeBess<Vst::Sample32>(Vst::Sample32**, Vst::Sample32**, Vst::Sample64, int32);
+	template void lunchboxProcessor::processDeBess<Vst::Sample64>(Vst::Sample64**, Vst::Sample64**, Vst::Sample64, int32);
+	template void lunchboxProcessor::processComp<Vst::Sample32>(Vst::Sample32**, Vst::Sample32**, Vst::Sample64, int32, Vst::Sample32**);
+	template void lunchboxProcessor::processComp<Vst::Sample64>(Vst::Sample64**, Vst::Sample64**, Vst::Sample64, int32, Vst::Sample64**);
+	template void lunchboxProcessor::processGate<Vst::Sample32>(Vst::Sample32**, Vst::Sample32**, Vst::Sample64, int32, Vst::Sample32**);
+	template void lunchboxProcessor::processGate<Vst::Sample64>(Vst::Sample64**, Vst::Sample64**, Vst::Sample64, int32, Vst::Sample64**);
+	template void lunchboxProcessor::processInflator<Vst::Sample32>(Vst::Sample32**, Vst::Sample32**, Vst::Sample64, int32);
+	template void lunchboxProcessor::processInflator<Vst::Sample64>(Vst::Sample64**, Vst::Sample64**, Vst::Sample64, int32);
+	template void lunchboxProcessor::processInput<Vst::Sample32>(Vst::Sample32**, Vst::Sample32**, Vst::Sample64, int32);
+	template void lunchboxProcessor::processInput<Vst::Sample64>(Vst::Sample64**, Vst::Sample64**, Vst::Sample64, int32);
+	template void lunchboxProcessor::processOutput<Vst::Sample32>(Vst::Sample32**, Vst::Sample32**, Vst::Sample64, int32, int32);
+	template void lunchboxProcessor::processOutput<Vst::Sample64>(Vst::Sample64**, Vst::Sample64**, Vst::Sample64, int32, int32);
+
 	//------------------------------------------------------------------------
 } // namespace yg331
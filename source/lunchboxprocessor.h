@@ -6,8 +6,18 @@
 
 #include "public.sdk/source/vst/vstaudioeffect.h"
 #include "lunchboxcids.h"
-
+#include "lunchboxsmoother.h"
+#include "lunchboxkernels.h"
+#include "lunchboxoversampler.h"
+#include "lunchboxmeter.h"
+#include "lunchboxloudness.h"
+#include "lunchboxlimiter.h"
+#include "lunchboxtiming.h"
+
+#include <atomic>
 #include <math.h>
+#include <vector>
+#ifndef M_PI
 #define M_E        2.71828182845904523536   // e
 #define M_LOG2E    1.44269504088896340736   // log2(e)
 #define M_LOG10E   0.434294481903251827651  // log10(e)
@@ -21,11 +31,14 @@
 #define M_2_SQRTPI 1.12837916709551257390   // 2/sqrt(pi)
 #define M_SQRT2    1.41421356237309504880   // sqrt(2)
 #define M_SQRT1_2  0.707106781186547524401  // 1/sqrt(2)
+#endif
 
 using namespace Steinberg;
 
 namespace yg331 {
 
+	class LunchboxBank;
+
 	//------------------------------------------------------------------------
 	//  lunchboxProcessor
 	//------------------------------------------------------------------------
@@ -50,13 +63,28 @@ namespace yg331 {
 		/** Called at the end before destructor */
 		Steinberg::tresult PLUGIN_API terminate() SMTG_OVERRIDE;
 
+		/** Widest bus accepted, one bit per speaker in a SpeakerArrangement. */
+		static const Steinberg::int32 kMaxChannels = 64;
+
 		Steinberg::tresult PLUGIN_API setBusArrangements(
 			Steinberg::Vst::SpeakerArrangement* inputs, Steinberg::int32 numIns,
 			Steinberg::Vst::SpeakerArrangement* outputs, Steinberg::int32 numOuts
 		) SMTG_OVERRIDE {
-			// we only support one in and output bus and these busses must have the same number of channels
-			if (numIns == 1 && numOuts == 1 && Vst::SpeakerArr::getChannelCount(inputs[0]) == 2 && Vst::SpeakerArr::getChannelCount(outputs[0]) == 2)
-				return AudioEffect::setBusArrangements(inputs, numIns, outputs, numOuts);
+			// one in and one output bus with the same number of channels, mono up to kMaxChannels,
+			// and the sidechain in mono or stereo
+			if ((numIns == 1 || numIns == 2) && numOuts == 1)
+			{
+				int32 channels = Vst::SpeakerArr::getChannelCount(inputs[0]);
+				int32 sideChannels = (numIns == 2) ? Vst::SpeakerArr::getChannelCount(inputs[1]) : 1;
+				if (channels >= 1 && channels <= kMaxChannels && Vst::SpeakerArr::getChannelCount(outputs[0]) == channels &&
+					sideChannels >= 1 && sideChannels <= 2)
+				{
+					tresult result = AudioEffect::setBusArrangements(inputs, numIns, outputs, numOuts);
+					if (result == kResultTrue)
+						setupChannels(channels);
+					return result;
+				}
+			}
 			return kResultFalse;
 		};
 
@@ -66,6 +94,14 @@ namespace yg331 {
 		/** Will be called before any process call */
 		Steinberg::tresult PLUGIN_API setupProcessing(Steinberg::Vst::ProcessSetup& newSetup) SMTG_OVERRIDE;
 
+		/** The oversampling filters of Channel9, Inflator and Gate, and the
+		    lookahead of the limiter while Safe is on */
+		Steinberg::uint32 PLUGIN_API getLatencySamples() SMTG_OVERRIDE;
+
+		/** How long the output goes on after the input stops: the latency, the
+		    filters ringing down, MeowMu's release and the gate closing */
+		Steinberg::uint32 PLUGIN_API getTailSamples() SMTG_OVERRIDE;
+
 		/** Asks if a given sample size is supported see SymbolicSampleSizes. */
 		Steinberg::tresult PLUGIN_API canProcessSampleSize(Steinberg::int32 symbolicSampleSize) SMTG_OVERRIDE;
 
@@ -76,147 +112,319 @@ namespace yg331 {
 		Steinberg::tresult PLUGIN_API setState(Steinberg::IBStream* state) SMTG_OVERRIDE;
 		Steinberg::tresult PLUGIN_API getState(Steinberg::IBStream* state) SMTG_OVERRIDE;
 
+		/** Answers kMeterRequestMessage with the meter frames since the last one,
+		    and kLatencyRequestMessage once the latency has moved on from what
+		    the host last asked for */
+		Steinberg::tresult PLUGIN_API notify(Steinberg::Vst::IMessage* message) SMTG_OVERRIDE;
+
+		/** Runs the whole chain (or bypass) on one automation sub-block.
+		    inputSilence : the silence flags of the input bus, returns those of the output
+		    keys : the sidechain, one channel per channel of inputs, or nullptr */
 		template <typename SampleType>
-		void processChannel9(SampleType** inputs, Vst::Sample64 getSampleRate, int32 sampleFrames);
+		uint64 processSubBlock(SampleType** inputs, SampleType** outputs, Vst::Sample64 getSampleRate, int32 sampleFrames, int32 precision, uint64 inputSilence, SampleType** keys = nullptr);
 
+		/** All stages in one pass per sample, bit-identical to the per-stage path.
+		    compKeys, gateKeys : the sidechain for MeowMu and the Gate, or nullptr */
 		template <typename SampleType>
-		void processEQ(SampleType** inputs, Vst::Sample64 getSampleRate, int32 sampleFrames);
+		void processFused(SampleType** inputs, SampleType** outputs, Vst::Sample64 getSampleRate, int32 sampleFrames, int32 precision, SampleType** compKeys = nullptr, SampleType** gateKeys = nullptr);
+
+		/** Per-stage path (one pass over the buffers per stage) for A/B comparison */
+		void setFusedKernel(bool state) { fusedKernel = state; }
+		bool isFusedKernel() const { return fusedKernel; }
+
+		/** Off: the chain stops before Output, no gain and no dither, for an
+		    offline pass that applies them afterwards (the renderer's --normalize) */
+		void setOutputStage(bool state) { outputStage = state; }
+		bool isOutputStage() const { return outputStage; }
+
+		/** True peak the limiter holds to, kLimiterCeilingDb unless an offline render asks otherwise */
+		void setLimiterCeiling(Vst::Sample64 ceilingDb) { setCoeffParam(limiterCeilingDb, ceilingDb, kDirtyLimiter); }
+
+		/** libm sin / cos in Channel9 and Gate instead of the polynomials (lunchboxfastmath.h) */
+		void setPreciseMath(bool state) { if (preciseMath != state) dirtyCoeffs |= kDirtyChannel9 | kDirtyGate; preciseMath = state; }
+		bool isPreciseMath() const { return preciseMath; }
+
+		/** Loudness of the output since setActive(true), for offline renders */
+		const LoudnessMeter& getLoudness() const { return loudness; }
+
+		/** At the end of an offline render: counts the unfinished meter frame
+		    and what the true peak filter still holds into the meters */
+		void flushMeters();
+
+		template <typename SampleType>
+		void processChannel9(SampleType** inputs, SampleType** outputs, Vst::Sample64 getSampleRate, int32 sampleFrames);
+
+		template <typename SampleType>
+		void processEQ(SampleType** inputs, SampleType** outputs, Vst::Sample64 getSampleRate, int32 sampleFrames);
 
 		template <typename SampleType>
-		void processDeBess(SampleType** inputs, Vst::Sample64 getSampleRate, int32 sampleFrames);
+		void processDeBess(SampleType** inputs, SampleType** outputs, Vst::Sample64 getSampleRate, int32 sampleFrames);
 
 		template <typename SampleType>
-		void processComp(SampleType** inputs, Vst::Sample64 getSampleRate, int32 sampleFrames);
+		void processComp(SampleType** inputs, SampleType** outputs, Vst::Sample64 getSampleRate, int32 sampleFrames, SampleType** keys = nullptr);
 
 		template <typename SampleType>
-		void processGate(SampleType** inputs, Vst::Sample64 getSampleRate, int32 sampleFrames);
+		void processGate(SampleType** inputs, SampleType** outputs, Vst::Sample64 getSampleRate, int32 sampleFrames, SampleType** keys = nullptr);
 
 		template <typename SampleType>
-		void processInflator(SampleType** inputs, Vst::Sample64 getSampleRate, int32 sampleFrames);
+		void processInflator(SampleType** inputs, SampleType** outputs, Vst::Sample64 getSampleRate, int32 sampleFrames);
 
 		template <typename SampleType>
-		void processInput(SampleType** inputs, Vst::Sample64 getSampleRate, int32 sampleFrames);
+		void processLimiter(SampleType** inputs, SampleType** outputs, Vst::Sample64 getSampleRate, int32 sampleFrames);
 
 		template <typename SampleType>
-		void processOutput(SampleType** inputs, Vst::Sample64 getSampleRate, int32 sampleFrames, int32 precision);
+		void processInput(SampleType** inputs, SampleType** outputs, Vst::Sample64 getSampleRate, int32 sampleFrames);
+
+		template <typename SampleType>
+		void processOutput(SampleType** inputs, SampleType** outputs, Vst::Sample64 getSampleRate, int32 sampleFrames, int32 precision);
 
 		template <typename SampleType>
 		void processBypass(SampleType** inputs, Vst::Sample64 getSampleRate, int32 sampleFrames);
 
 		inline void setCoeffs(double Fs);
+		void setParameter(Vst::ParamID id, Vst::ParamValue value);
+		/** param = value, and the stages reading it need new coefficients if it changed */
+		template <typename T>
+		void setCoeffParam(T& param, T value, uint32 stages) {
+			if (param != value) dirtyCoeffs |= stages;
+			param = value;
+		}
+		void resetSmoothers();
+		void setSmoothed(LinearSmoother& smoother, Vst::Sample64 value) {
+			if (snapSmoothers) smoother.reset(value);
+			else smoother.setTarget(value);
+		}
+		void setPeakCoeffs(Vst::Sample64 focus);
 		
 
 		Vst::Sample64 norm_to_gain(Vst::Sample64 plainValue) {
 			return exp(log(10.0) * (24.0 * plainValue - 12.0) / 20.0);
 		}
-		Vst::Sample64 VuPPMconvert(Vst::Sample64 plainValue, Vst::Sample64 Min, Vst::Sample64 Max, Vst::Sample64 Mid)
+
+
+		//------------------------------------------------------------------------
+	protected:
+		friend class LunchboxBank; // shares the coefficient code and the smoothers
+
+		// Per-block stage coefficients, see lunchboxkernels.h. updateCoeffs()
+		// only runs the prepareX() whose parameters, sample rate or
+		// oversampling have changed since the last block.
+		void updateCoeffs(Vst::Sample64 getSampleRate);
+		void prepareChannel9(Vst::Sample64 getSampleRate, Channel9Coeffs& c);
+		void prepareEQ(EQCoeffs& c);
+		void prepareDeBess(Vst::Sample64 getSampleRate, DeBessCoeffs& c);
+		void prepareComp(Vst::Sample64 getSampleRate, CompCoeffs& c);
+		void prepareGate(Vst::Sample64 getSampleRate, GateCoeffs& c);	// at the oversampled rate
+		void prepareInflator(InflatorCoeffs& c);
+		void prepareLimiter(Vst::Sample64 getSampleRate, LimiterCoeffs& c);
+
+		// the Output dither, lane by lane with one generator per channel
+		template <typename V>
+		inline void tickOutput(V& inputSample, Vst::Sample64 gain, int32 precision, uint32* fpd);
+
+		//------------------------------------------------------------------------
+		// Channels
+		// The state is kept in lanes: channels 0-1, 2-3, ... in Double2 pairs,
+		// an odd last channel (the only one on a mono bus) in a Double1, so
+		// mono does not carry a second channel along.
+		//------------------------------------------------------------------------
+		template <typename V>
+		struct ChannelGroup
 		{
-			double dB = 20.0 * log10(plainValue);
-			double normValue;
+			using Lanes = V;
+
+			Channel9State<V> channel9;
+			EQState<V> eq;
+			DeBessState<V> deBess;
+			CompState<V> comp;
+			GateState<V> gate;
+			LimiterState<V> limiter;
+			uint32 fpd[V::kLanes];	// dither
+			TruePeakState<V> truePeak;	// output meter
+			KWeightState<V> kWeight;	// output loudness
+
+			// around each of the nonlinear stages
+			OversamplerState<V> overChannel9;
+			OversamplerState<V> overInflator;
+			OversamplerState<V> overGate;
+
+			// the shared detectors of a pair in the linked and mono sum modes
+			DeBessState<Double1> deBessLink;
+			CompState<Double1> compLink;
+
+			// the sidechain, in time with the input of MeowMu and of the Gate
+			KeyDelayState<V> compKey;
+			KeyDelayState<V> gateKey;
+
+			// silence: frames since the input of the group last had signal, and
+			// since the gate of each lane was last open
+			int32 silentFrames = 0;
+			int32 gateShutFrames[V::kLanes];
+			bool sleeping = false;	// silent for longer than tailFrames, the stages skip it
+
+			ChannelGroup()
+			{
+				for (int i = 0; i < V::kLanes; i++) fpd[i] = 1;
+				for (int i = 0; i < V::kLanes; i++) gateShutFrames[i] = 0;
+			}
+		};
 
-			if (dB > Max) normValue = 1.0;
-			else if (dB > Mid) normValue = (dB - (2 * Mid - Max)) / (2 * Max - 2 * Mid);
-			else if (dB > Min) normValue = (dB - Min) / (2 * Mid - 2 * Min);
-			else normValue = 0.0;
+		// DeBess and MeowMu of one group in the iParamDetect mode, an odd
+		// channel is always detected on its own
+		inline void tickDeBessGroup(ChannelGroup<Double2>& group, Double2& inputSample, const DeBessCoeffs& c, Vst::Sample64& tmp);
+		inline void tickDeBessGroup(ChannelGroup<Double1>& group, Double1& inputSample, const DeBessCoeffs& c, Vst::Sample64& tmp);
+		// key : what MeowMu listens to, inputSample itself without a sidechain
+		inline void tickCompGroup(ChannelGroup<Double2>& group, Double2& inputSample, Double2 key, const CompCoeffs& c, Vst::Sample64& tmp);
+		inline void tickCompGroup(ChannelGroup<Double1>& group, Double1& inputSample, Double1 key, const CompCoeffs& c, Vst::Sample64& tmp);
+		// MeowMu over frames <= kCompBlock frames of one group, in place, in
+		// either engine, keyed by key (scratch, Mid/Side encodes it in place)
+		// or, if it is nullptr, by block
+		template <typename V>
+		inline void processCompBlock(ChannelGroup<V>& group, V* block, V* key, int32 frames, const CompCoeffs& c, Vst::Sample64& tmp);
+		inline void compEfficientGroup(ChannelGroup<Double2>& group, Double2* block, Double2* key, int32 frames, const CompCoeffs& c, Vst::Sample64& tmp);
+		inline void compEfficientGroup(ChannelGroup<Double1>& group, Double1* block, Double1* key, int32 frames, const CompCoeffs& c, Vst::Sample64& tmp);
+
+		/** Allocates the state for a new channel count, from setBusArrangements. */
+		void setupChannels(int32 channels);
+
+		/** Applies iParamOversampling and iParamOversamplingFilter, filters start empty on a change.
+		    From applySettings only, process() reads the filter state. */
+		void setupOversampling();
+		void resetOversampling();
+
+		/** Empties the limiter's lookahead, for when Safe comes on: what it
+		    held belongs to long ago */
+		void resetLimiter();
+
+		/** On the audio thread (or while processing is off), before the stages
+		    run: applies a setState, the oversampling settings, resets the
+		    limiter if Safe came on, seeds the link detectors if Detect moved
+		    and empties the key delays if Sidechain did */
+		void applySettings();
+
+		/** Detect moves into or out of Linked / Mono Sum: the pairs' shared
+		    detectors start from the channel that was held down hardest, or
+		    their own from the shared one, so the gain does not jump */
+		void seedLinks(int32 oldDetect, int32 newDetect);
+
+		/** fn(group, its input channels, its output channels) for every pair, then the odd channel,
+		    leaving out sleeping groups.
+		    A frame is read before it is written, so inputs and outputs may be the same buffers. */
+		template <typename SampleType, typename Fn>
+		void forEachGroup(SampleType** inputs, SampleType** outputs, Fn fn)
+		{
+			for (size_t g = 0; g < pairs.size(); g++)
+				if (!pairs[g].sleeping) fn(pairs[g], inputs + 2 * g, outputs + 2 * g);
+			if ((numChannels & 1) && !single.sleeping)
+				fn(single, inputs + numChannels - 1, outputs + numChannels - 1);
+		}
 
-			return normValue;
+		/** The same, fn(group, inputs, outputs, its sidechain channels or nullptr) */
+		template <typename SampleType, typename Fn>
+		void forEachGroup(SampleType** inputs, SampleType** outputs, SampleType** keys, Fn fn)
+		{
+			forEachGroup(inputs, outputs, [&](auto& group, SampleType** in, SampleType** out) {
+				fn(group, in, out, keys ? keys + (in - inputs) : nullptr);
+			});
 		}
 
+		/** Silence before a sub-block: which groups sleep through it, and fresh
+		    detectors for those that wake up. keys : the sidechain while it
+		    keys a stage, else nullptr */
+		template <typename SampleType>
+		void detectSilence(SampleType** inputs, int32 sampleFrames, uint64 inputSilence, SampleType** keys);
+		/** Silence after it: zeroes the outputs of the sleeping groups and of
+		    lanes whose gate stayed shut, returns their silence flags */
+		template <typename SampleType>
+		uint64 applySilence(SampleType** outputs, int32 sampleFrames);
 
-		//------------------------------------------------------------------------
-	protected:
+		/** After a gate pass over a block, gateOpen : the largest gate value of each lane in it */
+		template <typename V>
+		void trackGate(ChannelGroup<V>& group, const V& gateOpen, int32 sampleFrames);
+
+		/** tailFrames, gateTailFrames and tailSamples from the current coefficients */
+		void updateTail();
 
-		uint32 fpdL = 1.0;
-		uint32 fpdR = 1.0; 
+		/** latencySamples from the oversampling and Safe, and compKeyDelay and
+		    gateKeyDelay, what that much of it lies before MeowMu and the Gate */
+		void updateLatency(Vst::Sample64 getSampleRate);
+
+		/** Output peak, RMS, true peak and K-weighted squares of a sub-block
+		    into meterSums, from what the host gets */
+		template <typename SampleType>
+		void meterOutput(SampleType** outputs, int32 sampleFrames);
+
+		int32 numChannels = 2;
+		std::vector<ChannelGroup<Double2>> pairs = std::vector<ChannelGroup<Double2>>(1);
+		ChannelGroup<Double1> single;
+
+		bool fusedKernel = true;
+		bool preciseMath = false;
+		bool outputStage = true;
+		Vst::Sample64 limiterCeilingDb = kLimiterCeilingDb;
+
+		// Coefficient cache
+		enum {
+			kDirtyChannel9 = 1 << 0,
+			kDirtyEQ = 1 << 1,
+			kDirtyDeBess = 1 << 2,
+			kDirtyComp = 1 << 3,
+			kDirtyGate = 1 << 4,
+			kDirtyInflator = 1 << 5,
+			kDirtyLimiter = 1 << 6,
+			kDirtyAll = (1 << 7) - 1
+		};
+		uint32 dirtyCoeffs = kDirtyAll;
+		std::atomic<bool> stateChanged{ false };	// setState wrote the parameters, applySettings follows up
+		bool limiterSafe = SafeInit;	// bParamSafe as the limiter last saw it
+		int32 linkDetect = DetectInit;	// iParamDetect as the detectors last saw it
+		int32 keySidechain = SidechainInit;	// iParamSidechain as the key delays last saw it
+
+		// Tails, in frames at the host rate: how long the chain rings on after
+		// its input goes silent, and how long the gate's downsampler does
+		int32 tailFrames = 0;
+		int32 gateTailFrames = 0;
+		std::atomic<uint32> tailSamples{ 0 };	// tailFrames for getTailSamples, which the host may call from any thread
+		std::atomic<uint32> latencySamples{ 0 };	// for getLatencySamples, the same
+		std::atomic<uint32> reportedLatency{ 0 };	// what getLatencySamples last answered
+		int32 compKeyDelay = 0;
+		int32 gateKeyDelay = 0;
+		Vst::Sample64 coeffsSampleRate = 0.0;
+		Channel9Coeffs channel9Coeffs = {};
+		DeBessCoeffs deBessCoeffs = {};
+		CompCoeffs compCoeffs = {};
+		GateCoeffs gateCoeffs = {};
+		InflatorCoeffs inflatorCoeffs = {};
+		LimiterCoeffs limiterCoeffs = {};
+
+		// Oversampling of the nonlinear stages, designed once
+		static const int32 kOversampledStages = 3;	// Channel9, Inflator, Gate
+		OversamplerCoeffs oversampler;
+
+		// Automation sub-blocks
+		static const int32 kMaxParamQueues = 64;	// more than the parameter count
+		static constexpr int32 kMinSubBlock = 8;	// shortest split for dense automation
+
+		// Parameter smoothing
+		static constexpr double kSmoothingMs = 20.0;
+		static const int32 kFocusUpdateStride = 16;	// 1.2kHz peak coefficients while Focus ramps
+
+		LinearSmoother smoothInput;		// gain
+		LinearSmoother smoothOutput;	// gain
+		LinearSmoother smoothDrive;
+		LinearSmoother smoothFocus;
+		LinearSmoother smoothInflate;
+		bool snapSmoothers = true;		// first values after activation jump, no ramp
 
 		// Channel9 + add Highpass
-		Vst::Sample64 iirSampleLA = 0.0;
-		Vst::Sample64 iirSampleRA = 0.0;
-		Vst::Sample64 iirSampleLB = 0.0;
-		Vst::Sample64 iirSampleRB = 0.0;
-		Vst::Sample64 lastSampleAL = 0.0;
-		Vst::Sample64 lastSampleBL = 0.0;
-		Vst::Sample64 lastSampleCL = 0.0;
-		Vst::Sample64 lastSampleAR = 0.0;
-		Vst::Sample64 lastSampleBR = 0.0;
-		Vst::Sample64 lastSampleCR = 0.0;
-		Vst::Sample64 biquadA[15] = { 0, };
-		Vst::Sample64 biquadB[15] = { 0, };
 		Vst::Sample64 iirAmount = 0.005832;
 		Vst::Sample64 threshold = 0.33362176;
 		Vst::Sample64 cutoff = 28811.0;
-		bool          flip_channel9 = false;
 
 		// EQ
-		Vst::Sample64 z_1k2[3] = { 0, }, p_1k2[3] = { 0, };
-		Vst::Sample64 x_1k2_L[3] = { 0, }, y_1k2_L[3] = { 0, };
-		Vst::Sample64 x_1k2_R[3] = { 0, }, y_1k2_R[3] = { 0, };
+		EQCoeffs eqCoeffs = {};
 		Vst::Sample64 K_1k2 = 0.0, K_1k2_2 = 0.0, Q_1k2 = 1.5;
-
-		Vst::Sample64 z_10[3] = { 0, }, p_10[3] = { 0, };
-		Vst::Sample64 x_10_L[3] = { 0, }, y_10_L[3] = { 0, };
-		Vst::Sample64 x_10_R[3] = { 0, }, y_10_R[3] = { 0, };
-		Vst::Sample64 z_40[3] = { 0, }, p_40[3] = { 0, };
-		Vst::Sample64 x_40_L[3] = { 0, }, y_40_L[3] = { 0, };
-		Vst::Sample64 x_40_R[3] = { 0, }, y_40_R[3] = { 0, };
-		Vst::Sample64 z_160[3] = { 0, },   p_160[3] = { 0, };
-		Vst::Sample64 x_160_L[3] = { 0, }, y_160_L[3] = { 0, };
-		Vst::Sample64 x_160_R[3] = { 0, }, y_160_R[3] = { 0, };
-		Vst::Sample64 z_640[3] = { 0, },   p_640[3] = { 0, };
-		Vst::Sample64 x_640_L[3] = { 0, }, y_640_L[3] = { 0, };
-		Vst::Sample64 x_640_R[3] = { 0, }, y_640_R[3] = { 0, };
-		Vst::Sample64 z_2k5[3] = { 0, },   p_2k5[3] = { 0, };
-		Vst::Sample64 x_2k5_L[3] = { 0, }, y_2k5_L[3] = { 0, };
-		Vst::Sample64 x_2k5_R[3] = { 0, }, y_2k5_R[3] = { 0, };
-		Vst::Sample64 z_20k[3] = { 0, },   p_20k[3] = { 0, };
-		Vst::Sample64 x_20k_L[3] = { 0, }, y_20k_L[3] = { 0, };
-		Vst::Sample64 x_20k_R[3] = { 0, }, y_20k_R[3] = { 0, };
-
-		// DeBess
-		Vst::Sample64 sL[41] = { 0, }, mL[41] = { 0, }, cL[41] = { 0, };
-		Vst::Sample64 ratioAL = 1.0;
-		Vst::Sample64 ratioBL = 1.0;
-		Vst::Sample64 iirSampleAL = 0.0;
-		Vst::Sample64 iirSampleBL = 0.0;
-
-		Vst::Sample64 sR[41] = { 0, }, mR[41] = { 0, }, cR[41] = { 0, };
-		Vst::Sample64 ratioAR = 1.0;
-		Vst::Sample64 ratioBR = 1.0;
-		Vst::Sample64 iirSampleAR = 0.0;
-		Vst::Sample64 iirSampleBR = 0.0;
-		bool          flip_DeBess = false;
-
-		// MeowMu
-		Vst::Sample64 muVaryL = 1.0;
-		Vst::Sample64 muAttackL = 0.0;
-		Vst::Sample64 muNewSpeedL = 0.0;
-		Vst::Sample64 muSpeedAL = 10000;
-		Vst::Sample64 muSpeedBL = 10000;
-		Vst::Sample64 muCoefficientAL = 1.0;
-		Vst::Sample64 muCoefficientBL = 1.0;
-		Vst::Sample64 previousL = 0.0;
-
-		Vst::Sample64 muVaryR = 1.0;
-		Vst::Sample64 muAttackR = 0.0;
-		Vst::Sample64 muNewSpeedR = 0.0;
-		Vst::Sample64 muSpeedAR = 10000;
-		Vst::Sample64 muSpeedBR = 10000;
-		Vst::Sample64 muCoefficientAR = 1.0;
-		Vst::Sample64 muCoefficientBR = 1.0;
-		Vst::Sample64 previousR = 0.0;
-		bool          flip_MeowMu = false;
-
-		//begin Gate
-		bool WasNegativeL = false;
-		int32 ZeroCrossL = 0;
-		Vst::Sample64 gaterollerL = 0.0;
-		Vst::Sample64 gateL = 0.0;
-
-		bool WasNegativeR = false;
-		int32 ZeroCrossR = 0;
-		Vst::Sample64 gaterollerR = 0.0;
-		Vst::Sample64 gateR = 0.0;
-		//end Gate
+		Vst::Sample64 peakFocus = -1.0;	// what the 1.2kHz peak coefficients are for, -1 : none
 
 		// Parameters
 		bool          bParamBypass = BypassInit;
@@ -239,15 +447,20 @@ namespace yg331 {
 		Vst::Sample32 fParamGate = GateInit;
 		Vst::Sample32 fParamInflate = InflateInit;
 		bool          bParamSafe = SafeInit;
-
-		Vst::Sample32 fParamInVuPPM = 0.0;
-		Vst::Sample32 fParamOutVuPPM = 0.0;
-		Vst::Sample32 fParamDeEssVuPPM = 1.0;
-		Vst::Sample32 fParamCompVuPPM = 1.0;
-		Vst::Sample32 fParamInVuPPMOld = 0.0;
-		Vst::Sample32 fParamOutVuPPMOld = 0.0;
-		Vst::Sample32 fParamDeEssVuPPMOld = 1.0;
-		Vst::Sample32 fParamCompVuPPMOld = 1.0;
+		int32         iParamDetect = DetectInit;
+		int32         iParamCompMode = CompModeInit;
+		int32         iParamSidechain = SidechainInit;
+		int32         iParamOversampling = OversamplingInit;
+		int32         iParamOversamplingFilter = OversamplingFilterInit;
+
+		// Meters, see lunchboxmeter.h: the sums of the current frame, its
+		// length at the host rate, and the frames the controller has not
+		// asked for yet
+		MeterSums meterSums;
+		int32 meterFrameLength = 441;
+		MeterRing meterRing;
+		KWeightCoeffs kWeightCoeffs = {};
+		LoudnessMeter loudness;
 
 	};
 	//------------------------------------------------------------------------
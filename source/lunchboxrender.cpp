@@ -0,0 +1,680 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2023 yg331.
+//------------------------------------------------------------------------
+// Headless offline renderer: runs lunchboxProcessor over WAV / raw PCM
+// files without a host and without VSTGUI.
+//------------------------------------------------------------------------
+
+#include "lunchboxprocessor.h"
+#include "lunchboxcids.h"
+#include "lunchboxaudiofile.h"
+#include "lunchboxdenormals.h"
+
+#include "public.sdk/source/vst/hosting/parameterchanges.h"
+#include "public.sdk/source/vst/vstpresetfile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace Steinberg;
+using namespace yg331;
+
+namespace {
+
+	//------------------------------------------------------------------------
+	// Parameter names as titled in lunchboxController
+	//------------------------------------------------------------------------
+	struct ParamName
+	{
+		const char* name;
+		Vst::ParamID id;
+	};
+
+	const ParamName kParamNames[] = {
+		{ "Bypass",    kParamBypass },
+		{ "Input",     kParamInput },
+		{ "Output",    kParamOutput },
+		{ "Drive",     kParamDrive },
+		{ "Lowcut",    kParamLowcut },
+		{ "Air",       kParamAir },
+		{ "High",      kParamHigh },
+		{ "Focus",     kParamFocus },
+		{ "Body",      kParamBody },
+		{ "Low",       kParamLow },
+		{ "Intensity", kParamIntensity },
+		{ "Sharpness", kParamSharpness },
+		{ "Depth",     kParamDepth },
+		{ "Listen",    kParamListen },
+		{ "Comp",      kParamComp },
+		{ "Speed",     kParamSpeed },
+		{ "Attack",    kParamAttack },
+		{ "Gate",      kParamGate },
+		{ "Inflate",   kParamInflate },
+		{ "Safe",      kParamSafe },
+		{ "Detect",    kParamDetect },
+		{ "Oversampling", kParamOversampling },
+		{ "Filter",    kParamOversamplingFilter },
+		{ "CompMode",  kParamCompMode },
+		{ "Sidechain", kParamSidechain },
+	};
+
+	// Entries of the list parameters, in enum order
+	const char* const kDetectNames[] = { "stereo", "linked", "mid/side", "mono sum" };
+	const char* const kOversamplingNames[] = { "off", "2x", "4x", "8x" };
+	const char* const kFilterNames[] = { "iir", "fir" };
+	const char* const kCompModeNames[] = { "vintage", "efficient" };
+	const char* const kSidechainNames[] = { "off", "comp", "gate", "both" };
+
+	struct ParamList
+	{
+		Vst::ParamID id;
+		const char* const* names;
+		int32 count;
+		const char* error;
+	};
+
+	const ParamList kParamLists[] = {
+		{ kParamDetect, kDetectNames, kNumDetectModes, "Detect is stereo, linked, mid/side or mono sum: " },
+		{ kParamOversampling, kOversamplingNames, kNumOversamplings, "Oversampling is off, 2x, 4x or 8x: " },
+		{ kParamOversamplingFilter, kFilterNames, kNumOversamplingFilters, "Filter is iir (low latency) or fir (linear phase): " },
+		{ kParamCompMode, kCompModeNames, kNumCompModes, "CompMode is vintage or efficient: " },
+		{ kParamSidechain, kSidechainNames, kNumSidechainModes, "Sidechain is off, comp, gate or both: " },
+	};
+
+	struct ParamSetting
+	{
+		Vst::ParamID id;
+		Vst::ParamValue value;
+	};
+
+	struct Options
+	{
+		const char* inputPath = nullptr;
+		const char* outputPath = nullptr;
+		const char* presetPath = nullptr;
+		const char* keyPath = nullptr;
+		std::vector<ParamSetting> settings;
+		int32 blockSize = 4096;
+		int32 precision = Vst::kSample64;
+		bool rawIn = false;
+		bool rawOut = false;
+		bool haveOutFormat = false;
+		SampleFormat outFormat = SampleFormat::kFloat32;
+		AudioFileInfo rawInfo;
+		bool quiet = false;
+		bool perStage = false;
+		bool precise = false;
+		bool normalize = false;
+		double targetLoudness = -16.0;	// LUFS
+		double truePeakCeiling = -1.0;	// dBTP
+	};
+
+	//------------------------------------------------------------------------
+	void printUsage()
+	{
+		fprintf(stderr,
+			"usage: airwindows_500_lunchbox_render [options] <input> <output>\n"
+			"\n"
+			"  -p, --preset <file>     .vstpreset, or a text file of \"Name = value\" lines\n"
+			"                          with normalized (0..1) values, e.g. \"Comp = 0.35\"\n"
+			"  -s, --set Name=value    set one normalized parameter (after the preset)\n"
+			"  -b, --block <frames>    processing block size (default 4096)\n"
+			"  --precision 32|64       process in Sample32 or Sample64 (default 64)\n"
+			"  --format <fmt>          output format s16|s24|s32|f32|f64 (default: input)\n"
+			"  --raw <fmt>             input is headerless interleaved PCM of <fmt>\n"
+			"  --rate <hz>             sample rate of raw input (default 48000)\n"
+			"  --channels <n>          channel count of raw input (default 2)\n"
+			"  --raw-out               write headerless PCM (implied by .raw/.pcm)\n"
+			"  --per-stage             run the stages one pass each instead of fused (A/B)\n"
+			"  --precise               libm sin / cos in Channel9 and Gate, not the polynomials\n"
+			"  --normalize <LUFS>      two passes: render up to Output, then set Output to\n"
+			"                          this integrated loudness (e.g. -16 stereo, -19 mono)\n"
+			"                          and limit\n"
+			"  --ceiling <dBTP>        true peak the --normalize limiter holds (default -1)\n"
+			"  --key <file>            sidechain input, mono or stereo at the input's rate\n"
+			"                          (raw like the input with --raw), silent past its end;\n"
+			"                          what it keys is the Sidechain parameter\n"
+			"  -q, --quiet             no progress report\n"
+			"\n"
+			"parameters:");
+		for (const auto& p : kParamNames)
+			fprintf(stderr, " %s", p.name);
+		fprintf(stderr, "\n");
+	}
+
+	//------------------------------------------------------------------------
+	bool equalsNoCase(const char* a, const std::string& b)
+	{
+#if defined(_MSC_VER)
+		return _stricmp(a, b.c_str()) == 0;
+#else
+		return strcasecmp(a, b.c_str()) == 0;
+#endif
+	}
+
+	bool findParam(const std::string& name, Vst::ParamID& id)
+	{
+		for (const auto& p : kParamNames) {
+			if (equalsNoCase(p.name, name)) { id = p.id; return true; }
+		}
+		return false;
+	}
+
+	std::string trim(const std::string& s)
+	{
+		size_t b = s.find_first_not_of(" \t\r\n");
+		size_t e = s.find_last_not_of(" \t\r\n");
+		return (b == std::string::npos) ? std::string() : s.substr(b, e - b + 1);
+	}
+
+	/** Parses "Name = value" / "Name=value"; on/off/true/false are accepted for switches,
+	    the entry names for the list parameters. */
+	bool parseSetting(const std::string& line, ParamSetting& setting, std::string& error)
+	{
+		size_t eq = line.find('=');
+		if (eq == std::string::npos) {
+			error = "expected Name = value: " + line;
+			return false;
+		}
+		std::string name = trim(line.substr(0, eq));
+		std::string value = trim(line.substr(eq + 1));
+
+		if (!findParam(name, setting.id)) {
+			error = "unknown parameter: " + name;
+			return false;
+		}
+		const ParamList* list = nullptr;
+		for (const auto& l : kParamLists)
+			if (l.id == setting.id) list = &l;
+
+		int32 entry = 0;
+		if (list)
+			while (entry < list->count && !equalsNoCase(list->names[entry], value)) entry++;
+
+		if (list && entry < list->count) setting.value = (Vst::ParamValue)entry / (list->count - 1);
+		else if (value == "on" || value == "true") setting.value = 1.0;
+		else if (value == "off" || value == "false") setting.value = 0.0;
+		else if (list && !value.empty() && !isdigit((unsigned char)value[0])) {
+			error = list->error + line;
+			return false;
+		}
+		else {
+			char* end = nullptr;
+			setting.value = strtod(value.c_str(), &end);
+			if (end == value.c_str() || setting.value < 0.0 || setting.value > 1.0) {
+				error = "value must be normalized 0..1: " + line;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//------------------------------------------------------------------------
+	bool loadTextPreset(const char* path, std::vector<ParamSetting>& settings, std::string& error)
+	{
+		FILE* f = fopen(path, "r");
+		if (!f) {
+			error = std::string("cannot open ") + path;
+			return false;
+		}
+		char buffer[512];
+		bool ok = true;
+		while (ok && fgets(buffer, sizeof(buffer), f)) {
+			std::string line = trim(buffer);
+			if (line.empty() || line[0] == '#' || line[0] == ';')
+				continue;
+			ParamSetting setting;
+			ok = parseSetting(line, setting, error);
+			if (ok) settings.push_back(setting);
+		}
+		fclose(f);
+		return ok;
+	}
+
+	bool loadVstPreset(const char* path, lunchboxProcessor* processor, std::string& error)
+	{
+		IPtr<IBStream> stream = owned(Vst::FileStream::open(path, "rb"));
+		if (!stream) {
+			error = std::string("cannot open ") + path;
+			return false;
+		}
+		if (!Vst::PresetFile::loadPreset(stream, klunchboxProcessorUID, processor)) {
+			error = std::string(path) + " is not an easybox500 preset";
+			return false;
+		}
+		return true;
+	}
+
+	bool endsWith(const char* s, const char* suffix)
+	{
+		size_t n = strlen(s), m = strlen(suffix);
+		return n >= m && strcmp(s + n - m, suffix) == 0;
+	}
+
+	//------------------------------------------------------------------------
+	bool parseArgs(int argc, char* argv[], Options& o)
+	{
+		std::vector<const char*> positional;
+		for (int i = 1; i < argc; i++)
+		{
+			std::string a = argv[i];
+			bool hasValue = i + 1 < argc;
+			if ((a == "-p" || a == "--preset") && hasValue) o.presetPath = argv[++i];
+			else if ((a == "-s" || a == "--set") && hasValue) {
+				ParamSetting setting;
+				std::string error;
+				if (!parseSetting(argv[++i], setting, error)) {
+					fprintf(stderr, "%s\n", error.c_str());
+					return false;
+				}
+				o.settings.push_back(setting);
+			}
+			else if ((a == "-b" || a == "--block") && hasValue) o.blockSize = atoi(argv[++i]);
+			else if (a == "--precision" && hasValue) o.precision = (atoi(argv[++i]) == 32) ? Vst::kSample32 : Vst::kSample64;
+			else if (a == "--format" && hasValue) {
+				if (!parseSampleFormat(argv[++i], o.outFormat)) return false;
+				o.haveOutFormat = true;
+			}
+			else if (a == "--raw" && hasValue) {
+				if (!parseSampleFormat(argv[++i], o.rawInfo.format)) return false;
+				o.rawIn = true;
+			}
+			else if (a == "--rate" && hasValue) o.rawInfo.sampleRate = atof(argv[++i]);
+			else if (a == "--channels" && hasValue) o.rawInfo.numChannels = atoi(argv[++i]);
+			else if (a == "--raw-out") o.rawOut = true;
+			else if (a == "--per-stage") o.perStage = true;
+			else if (a == "--precise") o.precise = true;
+			else if (a == "--normalize" && hasValue) {
+				o.normalize = true;
+				o.targetLoudness = atof(argv[++i]);
+			}
+			else if (a == "--ceiling" && hasValue) o.truePeakCeiling = atof(argv[++i]);
+			else if (a == "--key" && hasValue) o.keyPath = argv[++i];
+			else if (a == "-q" || a == "--quiet") o.quiet = true;
+			else if (a.size() > 1 && a[0] == '-') return false;
+			else positional.push_back(argv[i]);
+		}
+		if (positional.size() != 2 || o.blockSize <= 0)
+			return false;
+
+		o.inputPath = positional[0];
+		o.outputPath = positional[1];
+		if (endsWith(o.outputPath, ".raw") || endsWith(o.outputPath, ".pcm"))
+			o.rawOut = true;
+		return true;
+	}
+
+	//------------------------------------------------------------------------
+	template <typename SampleType>
+	struct BlockBuffers
+	{
+		std::vector<std::vector<SampleType>> data;
+		std::vector<SampleType*> ptr;
+
+		void resize(int32 channels, int32 frames)
+		{
+			data.assign(channels, std::vector<SampleType>(frames, 0));
+			ptr.resize(channels);
+			for (int32 ch = 0; ch < channels; ch++) ptr[ch] = data[ch].data();
+		}
+	};
+
+	/** Feeds the whole file through process() in blocks of o.blockSize, into
+	    an AudioFileWriter or the TempSampleFile of a two-pass render.
+	    keyReader : the sidechain, on the second input bus, or nullptr */
+	template <typename SampleType, typename Writer>
+	int64 render(lunchboxProcessor* processor, AudioFileReader& reader, AudioFileReader* keyReader, Writer& writer,
+		Vst::IParameterChanges* firstBlockChanges, const Options& o)
+	{
+		const int32 fileChannels = reader.getInfo().numChannels;
+		const int32 keyChannels = keyReader ? keyReader->getInfo().numChannels : 0;
+
+		std::vector<std::vector<double>> fileData(fileChannels, std::vector<double>(o.blockSize, 0.0));
+		std::vector<double*> filePtr(fileChannels);
+		for (int32 ch = 0; ch < fileChannels; ch++) filePtr[ch] = fileData[ch].data();
+		std::vector<std::vector<double>> keyData(keyChannels, std::vector<double>(o.blockSize, 0.0));
+		std::vector<double*> keyPtr(keyChannels);
+		for (int32 ch = 0; ch < keyChannels; ch++) keyPtr[ch] = keyData[ch].data();
+
+		// in the sample type of o.precision: the processor only reads in, and
+		// works on out in place once Input has written it
+		BlockBuffers<SampleType> in, out, key;
+		in.resize(fileChannels, o.blockSize);
+		out.resize(fileChannels, o.blockSize);
+		key.resize(keyChannels, o.blockSize);
+
+		Vst::AudioBusBuffers inBus[2], outBus;
+		inBus[0].numChannels = fileChannels;
+		inBus[1].numChannels = keyChannels;
+		outBus.numChannels = fileChannels;
+		Vst::ProcessData data;
+		data.processMode = Vst::kOffline;
+		data.symbolicSampleSize = o.precision;
+		data.numInputs = keyReader ? 2 : 1;
+		data.numOutputs = 1;
+		data.inputs = inBus;
+		data.outputs = &outBus;
+
+		// the settings go in with an empty call first, so the latency they
+		// add is known before any audio: that many frames are dropped at the
+		// start, and made up with silence after the end, so the output lines
+		// up with the input as it would in a host with delay compensation
+		data.numSamples = 0;
+		data.inputParameterChanges = firstBlockChanges;
+		inBus[0].channelBuffers64 = inBus[1].channelBuffers64 = outBus.channelBuffers64 = nullptr;
+		if (processor->process(data) != kResultOk) return -1;
+		data.inputParameterChanges = nullptr;
+		int64 skip = processor->getLatencySamples();
+		int64 flush = skip;
+
+		int64 frames = 0;
+		while (true)
+		{
+			int32 n = reader.read(filePtr.data(), o.blockSize);
+			if (n <= 0) {
+				if (flush == 0) break;
+				n = (int32)std::min<int64>(flush, o.blockSize);
+				for (int32 ch = 0; ch < fileChannels; ch++) std::fill(filePtr[ch], filePtr[ch] + n, 0.0);
+				flush -= n;
+			}
+
+			for (int32 ch = 0; ch < fileChannels; ch++)
+				for (int32 i = 0; i < n; i++) in.ptr[ch][i] = (SampleType)filePtr[ch][i];
+
+			// the key runs alongside the input, a shorter one goes silent
+			if (keyReader) {
+				int32 keyFrames = std::max(keyReader->read(keyPtr.data(), n), 0);
+				for (int32 ch = 0; ch < keyChannels; ch++) {
+					for (int32 i = 0; i < keyFrames; i++) key.ptr[ch][i] = (SampleType)keyPtr[ch][i];
+					std::fill(key.ptr[ch] + keyFrames, key.ptr[ch] + n, (SampleType)0);
+				}
+			}
+
+			inBus[0].silenceFlags = inBus[1].silenceFlags = 0;
+			outBus.silenceFlags = 0;
+			if (sizeof(SampleType) == sizeof(Vst::Sample32)) {
+				inBus[0].channelBuffers32 = (Vst::Sample32**)in.ptr.data();
+				inBus[1].channelBuffers32 = (Vst::Sample32**)key.ptr.data();
+				outBus.channelBuffers32 = (Vst::Sample32**)out.ptr.data();
+			}
+			else {
+				inBus[0].channelBuffers64 = (Vst::Sample64**)in.ptr.data();
+				inBus[1].channelBuffers64 = (Vst::Sample64**)key.ptr.data();
+				outBus.channelBuffers64 = (Vst::Sample64**)out.ptr.data();
+			}
+			data.numSamples = n;
+
+			if (processor->process(data) != kResultOk) return -1;
+
+			int32 start = (int32)std::min<int64>(skip, n);
+			skip -= start;
+			if (start == n) continue;
+			for (int32 ch = 0; ch < fileChannels; ch++)
+				for (int32 i = start; i < n; i++) filePtr[ch][i - start] = out.ptr[ch][i];
+			if (!writer.write(filePtr.data(), n - start)) return -1;
+
+			frames += n - start;
+		}
+		return frames;
+	}
+
+	/** Second pass of --normalize, over the mapped first pass (rendered with
+	    setOutputStage(false)): the Output stage at the gain set on the
+	    processor, then the limiter, into writer. Its lookahead is made up
+	    the way render() makes up the latency of the chain. */
+	template <typename SampleType>
+	bool finish(lunchboxProcessor* processor, const double* rendered, int64 numFrames, int32 numChannels,
+		Vst::Sample64 sampleRate, AudioFileWriter& writer, const Options& o)
+	{
+		ScopedDenormals noDenormals;
+
+		std::vector<std::vector<double>> fileData(numChannels, std::vector<double>(o.blockSize, 0.0));
+		std::vector<double*> filePtr(numChannels);
+		for (int32 ch = 0; ch < numChannels; ch++) filePtr[ch] = fileData[ch].data();
+		BlockBuffers<SampleType> block;
+		block.resize(numChannels, o.blockSize);
+
+		int64 skip = getLimiterLatency(sampleRate);
+		int64 flush = skip;
+
+		int64 pos = 0;
+		while (pos < numFrames || flush > 0)
+		{
+			int32 n;
+			if (pos < numFrames) {
+				n = (int32)std::min<int64>(o.blockSize, numFrames - pos);
+				const double* frame = rendered + pos * numChannels;
+				for (int32 i = 0; i < n; i++)
+					for (int32 ch = 0; ch < numChannels; ch++)
+						block.ptr[ch][i] = (SampleType)*frame++;
+				pos += n;
+			}
+			else {
+				n = (int32)std::min<int64>(flush, o.blockSize);
+				for (int32 ch = 0; ch < numChannels; ch++) std::fill(block.ptr[ch], block.ptr[ch] + n, (SampleType)0);
+				flush -= n;
+			}
+
+			processor->processOutput<SampleType>(block.ptr.data(), block.ptr.data(), sampleRate, n, o.precision);
+			processor->processLimiter<SampleType>(block.ptr.data(), block.ptr.data(), sampleRate, n);
+
+			int32 start = (int32)std::min<int64>(skip, n);
+			skip -= start;
+			if (start == n) continue;
+			for (int32 ch = 0; ch < numChannels; ch++)
+				for (int32 i = start; i < n; i++) filePtr[ch][i - start] = block.ptr[ch][i];
+			if (!writer.write(filePtr.data(), n - start)) return false;
+		}
+		return true;
+	}
+
+} // namespace
+
+//------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+	Options o;
+	if (!parseArgs(argc, argv, o)) {
+		printUsage();
+		return 2;
+	}
+
+	std::string error;
+	AudioFileReader reader;
+	bool opened = o.rawIn ? reader.openRaw(o.inputPath, o.rawInfo, error) : reader.openWav(o.inputPath, error);
+	if (!opened) {
+		fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+	AudioFileInfo info = reader.getInfo();
+	if (info.numChannels < 1 || info.numChannels > lunchboxProcessor::kMaxChannels) {
+		fprintf(stderr, "%s: %d channels, at most %d are supported\n", o.inputPath, info.numChannels, lunchboxProcessor::kMaxChannels);
+		return 1;
+	}
+
+	AudioFileReader keyReader;
+	if (o.keyPath) {
+		opened = o.rawIn ? keyReader.openRaw(o.keyPath, o.rawInfo, error) : keyReader.openWav(o.keyPath, error);
+		if (!opened) {
+			fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+		const AudioFileInfo& keyInfo = keyReader.getInfo();
+		if (keyInfo.numChannels < 1 || keyInfo.numChannels > 2 || keyInfo.sampleRate != info.sampleRate) {
+			fprintf(stderr, "%s: the key must be mono or stereo at %.0f Hz\n", o.keyPath, info.sampleRate);
+			return 1;
+		}
+	}
+
+	lunchboxProcessor* processor = new lunchboxProcessor;
+	if (processor->initialize(nullptr) != kResultOk) {
+		fprintf(stderr, "processor failed to initialize\n");
+		processor->release();
+		return 1;
+	}
+
+	// mono runs as mono, anything wider as one speaker per channel
+	Vst::SpeakerArrangement arr = info.numChannels == 1 ? Vst::SpeakerArr::kMono
+		: info.numChannels == 2 ? Vst::SpeakerArr::kStereo
+		: (Vst::SpeakerArrangement)(~0ull >> (64 - info.numChannels));
+	// --key adds the sidechain bus in its own width
+	Vst::SpeakerArrangement inArr[2] = { arr, Vst::SpeakerArr::kStereo };
+	if (o.keyPath) {
+		inArr[1] = keyReader.getInfo().numChannels == 1 ? Vst::SpeakerArr::kMono : Vst::SpeakerArr::kStereo;
+		processor->activateBus(Vst::kAudio, Vst::kInput, 1, true);
+	}
+	if (processor->setBusArrangements(inArr, o.keyPath ? 2 : 1, &arr, 1) != kResultTrue) {
+		fprintf(stderr, "processor rejected %d channels\n", info.numChannels);
+		processor->terminate();
+		processor->release();
+		return 1;
+	}
+	processor->setFusedKernel(!o.perStage);
+	processor->setPreciseMath(o.precise);
+
+	Vst::ProcessSetup setup;
+	setup.processMode = Vst::kOffline;
+	setup.symbolicSampleSize = o.precision;
+	setup.maxSamplesPerBlock = o.blockSize;
+	setup.sampleRate = info.sampleRate;
+	if (processor->setupProcessing(setup) != kResultOk) {
+		fprintf(stderr, "processor rejected %.0f Hz / %d frames\n", info.sampleRate, o.blockSize);
+		processor->terminate();
+		processor->release();
+		return 1;
+	}
+
+	// A .vstpreset restores the full state, a text preset is applied as
+	// parameter changes on the first block - the same way a host would.
+	std::vector<ParamSetting> settings;
+	bool presetOk = true;
+	if (o.presetPath) {
+		if (endsWith(o.presetPath, ".vstpreset")) presetOk = loadVstPreset(o.presetPath, processor, error);
+		else presetOk = loadTextPreset(o.presetPath, settings, error);
+	}
+	if (!presetOk) {
+		fprintf(stderr, "%s\n", error.c_str());
+		processor->terminate();
+		processor->release();
+		return 1;
+	}
+	settings.insert(settings.end(), o.settings.begin(), o.settings.end());
+
+	Vst::ParameterChanges firstBlockChanges((int32)settings.size());
+	for (const auto& s : settings) {
+		int32 index = 0;
+		if (Vst::IParamValueQueue* queue = firstBlockChanges.addParameterData(s.id, index))
+			queue->addPoint(0, s.value, index);
+	}
+
+	AudioFileInfo outInfo = info;
+	if (o.haveOutFormat) outInfo.format = o.outFormat;
+	AudioFileWriter writer;
+	if (!writer.open(o.outputPath, outInfo, o.rawOut, error)) {
+		fprintf(stderr, "%s\n", error.c_str());
+		processor->terminate();
+		processor->release();
+		return 1;
+	}
+
+	processor->setActive(true);
+	processor->setProcessing(true);
+
+	// --normalize renders the chain up to Output once into a temporary file,
+	// to measure it; the second pass only runs Output and the limiter over
+	// that file into the output
+	TempSampleFile firstPass;
+	if (o.normalize && !firstPass.open(info.numChannels, error)) {
+		fprintf(stderr, "%s\n", error.c_str());
+		processor->terminate();
+		processor->release();
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	int64 frames;
+	processor->setOutputStage(!o.normalize);
+	if (o.normalize)
+		frames = (o.precision == Vst::kSample32)
+			? render<Vst::Sample32>(processor, reader, o.keyPath ? &keyReader : nullptr, firstPass, &firstBlockChanges, o)
+			: render<Vst::Sample64>(processor, reader, o.keyPath ? &keyReader : nullptr, firstPass, &firstBlockChanges, o);
+	else
+		frames = (o.precision == Vst::kSample32)
+			? render<Vst::Sample32>(processor, reader, o.keyPath ? &keyReader : nullptr, writer, &firstBlockChanges, o)
+			: render<Vst::Sample64>(processor, reader, o.keyPath ? &keyReader : nullptr, writer, &firstBlockChanges, o);
+	processor->flushMeters();
+	const LoudnessMeter& loudness = processor->getLoudness();
+	double integrated = loudness.getIntegrated();
+	double loudnessRange = loudness.getLoudnessRange();
+	double maxMomentary = loudness.getMaxMomentary();
+	double maxShortTerm = loudness.getMaxShortTerm();
+	double truePeak = loudness.getTruePeak();
+	double truePeakDb = truePeak > 0.0 ? 20.0 * log10(truePeak) : kLoudnessSilence;
+
+	processor->setProcessing(false);
+	processor->setActive(false);
+
+	// Output takes the integrated loudness to the target, as far as its
+	// +-12 dB go, and the limiter holds the true peak to the ceiling
+	double gainDb = 0.0;
+	bool rangeLimited = false;
+	bool peakLimited = false;
+	if (o.normalize && frames > 0) {
+		if (integrated > kLoudnessAbsoluteGate) gainDb = o.targetLoudness - integrated;
+		double outputValue = (gainDb + 12.0) / 24.0;	// norm_to_gain backwards
+		if (outputValue < 0.0 || outputValue > 1.0) {
+			outputValue = std::min(std::max(outputValue, 0.0), 1.0);
+			gainDb = 24.0 * outputValue - 12.0;
+			rangeLimited = true;
+		}
+		peakLimited = (truePeakDb + gainDb > o.truePeakCeiling);
+
+		processor->setOutputStage(true);
+		processor->setLimiterCeiling(o.truePeakCeiling);
+		processor->setActive(true);
+		processor->setParameter(kParamOutput, outputValue);
+		const double* rendered = firstPass.map(error);
+		bool finished = rendered && ((o.precision == Vst::kSample32)
+			? finish<Vst::Sample32>(processor, rendered, frames, info.numChannels, info.sampleRate, writer, o)
+			: finish<Vst::Sample64>(processor, rendered, frames, info.numChannels, info.sampleRate, writer, o));
+		if (!finished) {
+			if (!error.empty()) fprintf(stderr, "%s\n", error.c_str());
+			frames = -1;
+		}
+		processor->setActive(false);
+		firstPass.close();
+	}
+	processor->terminate();
+	processor->release();
+	auto stop = std::chrono::steady_clock::now();
+
+	bool closed = writer.close();
+	if (frames < 0 || !closed) {
+		fprintf(stderr, "rendering %s failed\n", o.outputPath);
+		return 1;
+	}
+
+	if (!o.quiet) {
+		double seconds = std::chrono::duration<double>(stop - start).count();
+		double audio = frames / info.sampleRate;
+		fprintf(stderr, "%s: %.1f s of audio in %.2f s (%.0fx realtime)\n",
+			o.outputPath, audio, seconds, seconds > 0.0 ? audio / seconds : 0.0);
+		fprintf(stderr, "loudness%s: integrated %.1f LUFS, range %.1f LU, max momentary %.1f LUFS, max short-term %.1f LUFS, true peak %.1f dBTP\n",
+			o.normalize ? " up to Output" : "", integrated, loudnessRange, maxMomentary, maxShortTerm, truePeakDb);
+		if (o.normalize && integrated <= kLoudnessAbsoluteGate)
+			fprintf(stderr, "normalized: nothing above the %.0f LUFS gate, Output left at 0 dB\n", kLoudnessAbsoluteGate);
+		else if (o.normalize) {
+			fprintf(stderr, "normalized: Output %+.2f dB to %.1f LUFS%s, true peak %.1f dBTP%s\n",
+				gainDb, integrated + gainDb, rangeLimited ? " (held by the Output range)" : "",
+				peakLimited ? o.truePeakCeiling : truePeakDb + gainDb, peakLimited ? " (limited)" : "");
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,365 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2023 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+//------------------------------------------------------------------------
+//  Lane types for the DSP kernels
+//  Double2 holds one sample of the left and the right channel, lane 0 and
+//  lane 1. Only + - * / and sqrt are done in the vector unit, those round
+//  exactly like the scalar code; sin, cos, pow and exp go lane by lane
+//  through perLane() so the results stay bit-identical to the scalar build.
+//  (lunchboxfastmath.h has polynomial sin / cos made of + and * only.)
+//
+//  SSE2 on x86 / x64, NEON on arm64, plain doubles otherwise or when
+//  LUNCHBOX_NO_SIMD is defined.
+//
+//  Double1 is a single plain double for a lone (mono) channel. Double4 (AVX)
+//  and Double8 (AVX-512F) are there when the compiler targets them, for
+//  LunchboxBank which packs many strips side by side.
+//------------------------------------------------------------------------
+#if !defined(LUNCHBOX_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define LUNCHBOX_SIMD_SSE2 1
+#include <emmintrin.h>
+#elif !defined(LUNCHBOX_NO_SIMD) && (defined(__aarch64__) || defined(_M_ARM64))
+#define LUNCHBOX_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if !defined(LUNCHBOX_NO_SIMD) && (defined(__AVX__) || defined(__AVX512F__))
+#include <immintrin.h>
+#endif
+
+#include <math.h>
+
+namespace yg331 {
+
+#if defined(LUNCHBOX_SIMD_SSE2)
+	//------------------------------------------------------------------------
+	struct Mask2
+	{
+		__m128d m;
+	};
+
+	struct Double2
+	{
+		static const int kLanes = 2;
+		using Mask = Mask2;
+
+		__m128d v;
+
+		Double2() = default;
+		Double2(double x) : v(_mm_set1_pd(x)) {}
+		Double2(double l, double r) : v(_mm_setr_pd(l, r)) {}
+		explicit Double2(__m128d x) : v(x) {}
+
+		static Double2 load(const double* p) { return Double2(_mm_loadu_pd(p)); }
+		void store(double* p) const { _mm_storeu_pd(p, v); }
+		double lane(int i) const { return _mm_cvtsd_f64(i ? _mm_unpackhi_pd(v, v) : v); }
+	};
+
+	inline Double2 operator+(Double2 a, Double2 b) { return Double2(_mm_add_pd(a.v, b.v)); }
+	inline Double2 operator-(Double2 a, Double2 b) { return Double2(_mm_sub_pd(a.v, b.v)); }
+	inline Double2 operator*(Double2 a, Double2 b) { return Double2(_mm_mul_pd(a.v, b.v)); }
+	inline Double2 operator/(Double2 a, Double2 b) { return Double2(_mm_div_pd(a.v, b.v)); }
+	inline Double2 operator-(Double2 a) { return Double2(_mm_xor_pd(a.v, _mm_set1_pd(-0.0))); }
+	inline Double2 absLanes(Double2 a) { return Double2(_mm_andnot_pd(_mm_set1_pd(-0.0), a.v)); }
+	inline Double2 sqrtLanes(Double2 a) { return Double2(_mm_sqrt_pd(a.v)); }
+
+	inline Mask2 operator<(Double2 a, Double2 b) { return { _mm_cmplt_pd(a.v, b.v) }; }
+	inline Mask2 operator>(Double2 a, Double2 b) { return { _mm_cmpgt_pd(a.v, b.v) }; }
+	inline Mask2 operator<=(Double2 a, Double2 b) { return { _mm_cmple_pd(a.v, b.v) }; }
+	inline Mask2 operator>=(Double2 a, Double2 b) { return { _mm_cmpge_pd(a.v, b.v) }; }
+	inline Mask2 operator==(Double2 a, Double2 b) { return { _mm_cmpeq_pd(a.v, b.v) }; }
+	inline Mask2 operator&(Mask2 a, Mask2 b) { return { _mm_and_pd(a.m, b.m) }; }
+	inline Mask2 operator|(Mask2 a, Mask2 b) { return { _mm_or_pd(a.m, b.m) }; }
+	inline Mask2 operator!(Mask2 a) { return { _mm_xor_pd(a.m, _mm_castsi128_pd(_mm_set1_epi32(-1))) }; }
+	inline bool any(Mask2 a) { return _mm_movemask_pd(a.m) != 0; }
+	inline bool all(Mask2 a) { return _mm_movemask_pd(a.m) == 3; }
+	inline Mask2 makeMask(bool l, bool r) { return { _mm_castsi128_pd(_mm_set_epi64x(r ? -1 : 0, l ? -1 : 0)) }; }
+
+	/** m ? a : b, lane by lane */
+	inline Double2 select(Mask2 m, Double2 a, Double2 b) { return Double2(_mm_or_pd(_mm_and_pd(m.m, a.v), _mm_andnot_pd(m.m, b.v))); }
+
+	/** What a float buffer would hold */
+	inline Double2 roundToFloat(Double2 a) { return Double2(_mm_cvtps_pd(_mm_cvtpd_ps(a.v))); }
+
+#elif defined(LUNCHBOX_SIMD_NEON)
+	//------------------------------------------------------------------------
+	struct Mask2
+	{
+		uint64x2_t m;
+	};
+
+	struct Double2
+	{
+		static const int kLanes = 2;
+		using Mask = Mask2;
+
+		float64x2_t v;
+
+		Double2() = default;
+		Double2(double x) : v(vdupq_n_f64(x)) {}
+		Double2(double l, double r) : v(vsetq_lane_f64(r, vdupq_n_f64(l), 1)) {}
+		explicit Double2(float64x2_t x) : v(x) {}
+
+		static Double2 load(const double* p) { return Double2(vld1q_f64(p)); }
+		void store(double* p) const { vst1q_f64(p, v); }
+		double lane(int i) const { return i ? vgetq_lane_f64(v, 1) : vgetq_lane_f64(v, 0); }
+	};
+
+	inline Double2 operator+(Double2 a, Double2 b) { return Double2(vaddq_f64(a.v, b.v)); }
+	inline Double2 operator-(Double2 a, Double2 b) { return Double2(vsubq_f64(a.v, b.v)); }
+	inline Double2 operator*(Double2 a, Double2 b) { return Double2(vmulq_f64(a.v, b.v)); }
+	inline Double2 operator/(Double2 a, Double2 b) { return Double2(vdivq_f64(a.v, b.v)); }
+	inline Double2 operator-(Double2 a) { return Double2(vnegq_f64(a.v)); }
+	inline Double2 absLanes(Double2 a) { return Double2(vabsq_f64(a.v)); }
+	inline Double2 sqrtLanes(Double2 a) { return Double2(vsqrtq_f64(a.v)); }
+
+	inline Mask2 operator<(Double2 a, Double2 b) { return { vcltq_f64(a.v, b.v) }; }
+	inline Mask2 operator>(Double2 a, Double2 b) { return { vcgtq_f64(a.v, b.v) }; }
+	inline Mask2 operator<=(Double2 a, Double2 b) { return { vcleq_f64(a.v, b.v) }; }
+	inline Mask2 operator>=(Double2 a, Double2 b) { return { vcgeq_f64(a.v, b.v) }; }
+	inline Mask2 operator==(Double2 a, Double2 b) { return { vceqq_f64(a.v, b.v) }; }
+	inline Mask2 operator&(Mask2 a, Mask2 b) { return { vandq_u64(a.m, b.m) }; }
+	inline Mask2 operator|(Mask2 a, Mask2 b) { return { vorrq_u64(a.m, b.m) }; }
+	inline Mask2 operator!(Mask2 a) { return { veorq_u64(a.m, vdupq_n_u64(~0ull)) }; }
+	inline bool any(Mask2 a) { return (vgetq_lane_u64(a.m, 0) | vgetq_lane_u64(a.m, 1)) != 0; }
+	inline bool all(Mask2 a) { return (vgetq_lane_u64(a.m, 0) & vgetq_lane_u64(a.m, 1)) != 0; }
+	inline Mask2 makeMask(bool l, bool r) { return { vsetq_lane_u64(r ? ~0ull : 0, vdupq_n_u64(l ? ~0ull : 0), 1) }; }
+
+	/** m ? a : b, lane by lane */
+	inline Double2 select(Mask2 m, Double2 a, Double2 b) { return Double2(vbslq_f64(m.m, a.v, b.v)); }
+
+	/** What a float buffer would hold */
+	inline Double2 roundToFloat(Double2 a) { return Double2(vcvt_f64_f32(vcvt_f32_f64(a.v))); }
+
+#else
+	//------------------------------------------------------------------------
+	struct Mask2
+	{
+		bool m[2];
+	};
+
+	struct Double2
+	{
+		static const int kLanes = 2;
+		using Mask = Mask2;
+
+		double v[2];
+
+		Double2() = default;
+		Double2(double x) : v{ x, x } {}
+		Double2(double l, double r) : v{ l, r } {}
+
+		static Double2 load(const double* p) { return Double2(p[0], p[1]); }
+		void store(double* p) const { p[0] = v[0]; p[1] = v[1]; }
+		double lane(int i) const { return v[i]; }
+	};
+
+	inline Double2 operator+(Double2 a, Double2 b) { return Double2(a.v[0] + b.v[0], a.v[1] + b.v[1]); }
+	inline Double2 operator-(Double2 a, Double2 b) { return Double2(a.v[0] - b.v[0], a.v[1] - b.v[1]); }
+	inline Double2 operator*(Double2 a, Double2 b) { return Double2(a.v[0] * b.v[0], a.v[1] * b.v[1]); }
+	inline Double2 operator/(Double2 a, Double2 b) { return Double2(a.v[0] / b.v[0], a.v[1] / b.v[1]); }
+	inline Double2 operator-(Double2 a) { return Double2(-a.v[0], -a.v[1]); }
+	inline Double2 absLanes(Double2 a) { return Double2(fabs(a.v[0]), fabs(a.v[1])); }
+	inline Double2 sqrtLanes(Double2 a) { return Double2(::sqrt(a.v[0]), ::sqrt(a.v[1])); }
+
+	inline Mask2 operator<(Double2 a, Double2 b) { return { { a.v[0] < b.v[0], a.v[1] < b.v[1] } }; }
+	inline Mask2 operator>(Double2 a, Double2 b) { return { { a.v[0] > b.v[0], a.v[1] > b.v[1] } }; }
+	inline Mask2 operator<=(Double2 a, Double2 b) { return { { a.v[0] <= b.v[0], a.v[1] <= b.v[1] } }; }
+	inline Mask2 operator>=(Double2 a, Double2 b) { return { { a.v[0] >= b.v[0], a.v[1] >= b.v[1] } }; }
+	inline Mask2 operator==(Double2 a, Double2 b) { return { { a.v[0] == b.v[0], a.v[1] == b.v[1] } }; }
+	inline Mask2 operator&(Mask2 a, Mask2 b) { return { { a.m[0] && b.m[0], a.m[1] && b.m[1] } }; }
+	inline Mask2 operator|(Mask2 a, Mask2 b) { return { { a.m[0] || b.m[0], a.m[1] || b.m[1] } }; }
+	inline Mask2 operator!(Mask2 a) { return { { !a.m[0], !a.m[1] } }; }
+	inline bool any(Mask2 a) { return a.m[0] || a.m[1]; }
+	inline bool all(Mask2 a) { return a.m[0] && a.m[1]; }
+	inline Mask2 makeMask(bool l, bool r) { return { { l, r } }; }
+
+	/** m ? a : b, lane by lane */
+	inline Double2 select(Mask2 m, Double2 a, Double2 b) { return Double2(m.m[0] ? a.v[0] : b.v[0], m.m[1] ? a.v[1] : b.v[1]); }
+
+	/** What a float buffer would hold, through memory: GCC's SLP pass drops a plain (double)(float) pair here */
+	inline Double2 roundToFloat(Double2 a) { volatile float f[2] = { (float)a.v[0], (float)a.v[1] }; return Double2(f[0], f[1]); }
+#endif
+
+	//------------------------------------------------------------------------
+	struct Mask1
+	{
+		bool m;
+	};
+
+	struct Double1
+	{
+		static const int kLanes = 1;
+		using Mask = Mask1;
+
+		double v;
+
+		Double1() = default;
+		Double1(double x) : v(x) {}
+
+		static Double1 load(const double* p) { return Double1(p[0]); }
+		void store(double* p) const { p[0] = v; }
+		double lane(int) const { return v; }
+	};
+
+	inline Double1 operator+(Double1 a, Double1 b) { return Double1(a.v + b.v); }
+	inline Double1 operator-(Double1 a, Double1 b) { return Double1(a.v - b.v); }
+	inline Double1 operator*(Double1 a, Double1 b) { return Double1(a.v * b.v); }
+	inline Double1 operator/(Double1 a, Double1 b) { return Double1(a.v / b.v); }
+	inline Double1 operator-(Double1 a) { return Double1(-a.v); }
+	inline Double1 absLanes(Double1 a) { return Double1(fabs(a.v)); }
+	inline Double1 sqrtLanes(Double1 a) { return Double1(::sqrt(a.v)); }
+
+	inline Mask1 operator<(Double1 a, Double1 b) { return { a.v < b.v }; }
+	inline Mask1 operator>(Double1 a, Double1 b) { return { a.v > b.v }; }
+	inline Mask1 operator<=(Double1 a, Double1 b) { return { a.v <= b.v }; }
+	inline Mask1 operator>=(Double1 a, Double1 b) { return { a.v >= b.v }; }
+	inline Mask1 operator==(Double1 a, Double1 b) { return { a.v == b.v }; }
+	inline Mask1 operator&(Mask1 a, Mask1 b) { return { a.m && b.m }; }
+	inline Mask1 operator|(Mask1 a, Mask1 b) { return { a.m || b.m }; }
+	inline Mask1 operator!(Mask1 a) { return { !a.m }; }
+	inline bool any(Mask1 a) { return a.m; }
+	inline bool all(Mask1 a) { return a.m; }
+
+	/** m ? a : b */
+	inline Double1 select(Mask1 m, Double1 a, Double1 b) { return m.m ? a : b; }
+
+	/** What a float buffer would hold */
+	inline Double1 roundToFloat(Double1 a) { volatile float f = (float)a.v; return Double1(f); }
+
+#if !defined(LUNCHBOX_NO_SIMD) && defined(__AVX__)
+	//------------------------------------------------------------------------
+	struct Mask4
+	{
+		__m256d m;
+	};
+
+	struct Double4
+	{
+		static const int kLanes = 4;
+		using Mask = Mask4;
+
+		__m256d v;
+
+		Double4() = default;
+		Double4(double x) : v(_mm256_set1_pd(x)) {}
+		explicit Double4(__m256d x) : v(x) {}
+
+		static Double4 load(const double* p) { return Double4(_mm256_loadu_pd(p)); }
+		void store(double* p) const { _mm256_storeu_pd(p, v); }
+		double lane(int i) const { double t[kLanes]; store(t); return t[i]; }
+	};
+
+	inline Double4 operator+(Double4 a, Double4 b) { return Double4(_mm256_add_pd(a.v, b.v)); }
+	inline Double4 operator-(Double4 a, Double4 b) { return Double4(_mm256_sub_pd(a.v, b.v)); }
+	inline Double4 operator*(Double4 a, Double4 b) { return Double4(_mm256_mul_pd(a.v, b.v)); }
+	inline Double4 operator/(Double4 a, Double4 b) { return Double4(_mm256_div_pd(a.v, b.v)); }
+	inline Double4 operator-(Double4 a) { return Double4(_mm256_xor_pd(a.v, _mm256_set1_pd(-0.0))); }
+	inline Double4 absLanes(Double4 a) { return Double4(_mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v)); }
+	inline Double4 sqrtLanes(Double4 a) { return Double4(_mm256_sqrt_pd(a.v)); }
+
+	// ordered, non-signalling: false for NaN like the scalar compares
+	inline Mask4 operator<(Double4 a, Double4 b) { return { _mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ) }; }
+	inline Mask4 operator>(Double4 a, Double4 b) { return { _mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ) }; }
+	inline Mask4 operator<=(Double4 a, Double4 b) { return { _mm256_cmp_pd(a.v, b.v, _CMP_LE_OQ) }; }
+	inline Mask4 operator>=(Double4 a, Double4 b) { return { _mm256_cmp_pd(a.v, b.v, _CMP_GE_OQ) }; }
+	inline Mask4 operator==(Double4 a, Double4 b) { return { _mm256_cmp_pd(a.v, b.v, _CMP_EQ_OQ) }; }
+	inline Mask4 operator&(Mask4 a, Mask4 b) { return { _mm256_and_pd(a.m, b.m) }; }
+	inline Mask4 operator|(Mask4 a, Mask4 b) { return { _mm256_or_pd(a.m, b.m) }; }
+	inline Mask4 operator!(Mask4 a) { return { _mm256_xor_pd(a.m, _mm256_castsi256_pd(_mm256_set1_epi64x(-1))) }; }
+	inline bool any(Mask4 a) { return _mm256_movemask_pd(a.m) != 0; }
+	inline bool all(Mask4 a) { return _mm256_movemask_pd(a.m) == 15; }
+
+	/** m ? a : b, lane by lane */
+	inline Double4 select(Mask4 m, Double4 a, Double4 b) { return Double4(_mm256_blendv_pd(b.v, a.v, m.m)); }
+#endif
+
+#if !defined(LUNCHBOX_NO_SIMD) && defined(__AVX512F__)
+	//------------------------------------------------------------------------
+	struct Mask8
+	{
+		__mmask8 m;
+	};
+
+	struct Double8
+	{
+		static const int kLanes = 8;
+		using Mask = Mask8;
+
+		__m512d v;
+
+		Double8() = default;
+		Double8(double x) : v(_mm512_set1_pd(x)) {}
+		explicit Double8(__m512d x) : v(x) {}
+
+		static Double8 load(const double* p) { return Double8(_mm512_loadu_pd(p)); }
+		void store(double* p) const { _mm512_storeu_pd(p, v); }
+		double lane(int i) const { double t[kLanes]; store(t); return t[i]; }
+	};
+
+	inline Double8 operator+(Double8 a, Double8 b) { return Double8(_mm512_add_pd(a.v, b.v)); }
+	inline Double8 operator-(Double8 a, Double8 b) { return Double8(_mm512_sub_pd(a.v, b.v)); }
+	inline Double8 operator*(Double8 a, Double8 b) { return Double8(_mm512_mul_pd(a.v, b.v)); }
+	inline Double8 operator/(Double8 a, Double8 b) { return Double8(_mm512_div_pd(a.v, b.v)); }
+	// the sign flip goes through the integer unit, _mm512_xor_pd needs AVX-512DQ
+	inline Double8 operator-(Double8 a) { return Double8(_mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(a.v), _mm512_set1_epi64((long long)0x8000000000000000ull)))); }
+	inline Double8 absLanes(Double8 a) { return Double8(_mm512_abs_pd(a.v)); }
+	inline Double8 sqrtLanes(Double8 a) { return Double8(_mm512_sqrt_pd(a.v)); }
+
+	inline Mask8 operator<(Double8 a, Double8 b) { return { _mm512_cmp_pd_mask(a.v, b.v, _CMP_LT_OQ) }; }
+	inline Mask8 operator>(Double8 a, Double8 b) { return { _mm512_cmp_pd_mask(a.v, b.v, _CMP_GT_OQ) }; }
+	inline Mask8 operator<=(Double8 a, Double8 b) { return { _mm512_cmp_pd_mask(a.v, b.v, _CMP_LE_OQ) }; }
+	inline Mask8 operator>=(Double8 a, Double8 b) { return { _mm512_cmp_pd_mask(a.v, b.v, _CMP_GE_OQ) }; }
+	inline Mask8 operator==(Double8 a, Double8 b) { return { _mm512_cmp_pd_mask(a.v, b.v, _CMP_EQ_OQ) }; }
+	inline Mask8 operator&(Mask8 a, Mask8 b) { return { (__mmask8)(a.m & b.m) }; }
+	inline Mask8 operator|(Mask8 a, Mask8 b) { return { (__mmask8)(a.m | b.m) }; }
+	inline Mask8 operator!(Mask8 a) { return { (__mmask8)~a.m }; }
+	inline bool any(Mask8 a) { return a.m != 0; }
+	inline bool all(Mask8 a) { return a.m == 0xff; }
+
+	/** m ? a : b, lane by lane */
+	inline Double8 select(Mask8 m, Double8 a, Double8 b) { return Double8(_mm512_mask_blend_pd(m.m, b.v, a.v)); }
+#endif
+
+	//------------------------------------------------------------------------
+	/** Applies a scalar function to every lane, for the libm calls. */
+	template <typename V, typename Fn>
+	inline V perLane(const V& x, Fn fn)
+	{
+		double t[V::kLanes];
+		x.store(t);
+		for (int i = 0; i < V::kLanes; i++)
+			t[i] = fn(t[i]);
+		return V::load(t);
+	}
+
+	/** Largest lane, 0 if all lanes are negative (the meters start from 0). */
+	template <typename V>
+	inline double maxOfLanes(const V& x)
+	{
+		double t[V::kLanes];
+		x.store(t);
+		double peak = 0.0;
+		for (int i = 0; i < V::kLanes; i++)
+			if (t[i] > peak) peak = t[i];
+		return peak;
+	}
+
+	/** Sum of all lanes, lane 0 first. */
+	template <typename V>
+	inline double sumOfLanes(const V& x)
+	{
+		double t[V::kLanes];
+		x.store(t);
+		double sum = 0.0;
+		for (int i = 0; i < V::kLanes; i++)
+			sum += t[i];
+		return sum;
+	}
+
+	//------------------------------------------------------------------------
+} // namespace yg331
@@ -0,0 +1,80 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2023 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include "pluginterfaces/vst/vsttypes.h"
+
+#include <vector>
+
+namespace yg331 {
+
+	//------------------------------------------------------------------------
+	//  LinearSmoother
+	//  Linear ramp towards the last target, written per block into a buffer
+	//  the stages read sample by sample. The ramp time is given in ms, so it
+	//  is the same at every sample rate.
+	//------------------------------------------------------------------------
+	class LinearSmoother
+	{
+	public:
+		/** Allocates the block buffer, call from setupProcessing only. */
+		void setup(double sampleRate, Steinberg::int32 maxSamplesPerBlock, double rampMs)
+		{
+			rampLength = (Steinberg::int32)(sampleRate * rampMs * 0.001 + 0.5);
+			if (rampLength < 1) rampLength = 1;
+			remaining = 0;
+			current = target;
+			buffer.assign(maxSamplesPerBlock > 0 ? maxSamplesPerBlock : 1, current);
+		}
+
+		/** Jumps to value without a ramp. */
+		void reset(Steinberg::Vst::Sample64 value)
+		{
+			current = target = value;
+			step = 0.0;
+			remaining = 0;
+		}
+
+		void setTarget(Steinberg::Vst::Sample64 value)
+		{
+			if (value == target) return;
+			target = value;
+			step = (target - current) / rampLength;
+			remaining = rampLength;
+		}
+
+		bool isSmoothing() const { return remaining > 0; }
+		Steinberg::Vst::Sample64 getTarget() const { return target; }
+		Steinberg::int32 getCapacity() const { return (Steinberg::int32)buffer.size(); }
+
+		/** Fills the next sampleFrames values (at most getCapacity()) and returns them. */
+		const Steinberg::Vst::Sample64* process(Steinberg::int32 sampleFrames)
+		{
+			Steinberg::Vst::Sample64* out = buffer.data();
+			Steinberg::int32 ramp = (sampleFrames < remaining) ? sampleFrames : remaining;
+			Steinberg::Vst::Sample64 start = current;
+
+			// two plain loops without branches, so both vectorize
+			for (Steinberg::int32 i = 0; i < ramp; i++)
+				out[i] = start + step * (i + 1);
+			remaining -= ramp;
+			current = (remaining > 0) ? start + step * ramp : target;
+			for (Steinberg::int32 i = ramp; i < sampleFrames; i++)
+				out[i] = current;
+
+			return out;
+		}
+
+	private:
+		std::vector<Steinberg::Vst::Sample64> buffer;
+		Steinberg::Vst::Sample64 current = 0.0;
+		Steinberg::Vst::Sample64 target = 0.0;
+		Steinberg::Vst::Sample64 step = 0.0;
+		Steinberg::int32 rampLength = 1;
+		Steinberg::int32 remaining = 0;
+	};
+
+	//------------------------------------------------------------------------
+} // namespace yg331
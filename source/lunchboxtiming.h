@@ -0,0 +1,56 @@
+//------------------------------------------------------------------------
+// Copyright(c) 2023 yg331.
+//------------------------------------------------------------------------
+
+#pragma once
+
+#include <cmath>
+
+namespace yg331 {
+
+	//------------------------------------------------------------------------
+	//  Timing
+	//  Attack, release and hold times of the dynamics stages, from ms to per
+	//  sample values at the rate a stage runs at. The airwindows stages were
+	//  written with per-sample constants; they keep the timing they have at
+	//  kTimingReferenceRate, the rate live sessions run at, and are scaled
+	//  from there, so a render at 96 or 192 kHz moves as a 48 kHz session
+	//  does and one at 48 kHz is bit for bit what it was. At any other rate
+	//  the output differs from the unscaled stages, at 44.1 kHz too.
+	//------------------------------------------------------------------------
+	static const double kTimingReferenceRate = 48000.0;
+
+	/** Samples at sampleRate in ms */
+	inline double msToSamples(double ms, double sampleRate)
+	{
+		return ms * 0.001 * sampleRate;
+	}
+
+	/** Samples at sampleRate for every sample at the reference rate */
+	inline double getTimeScale(double sampleRate)
+	{
+		return sampleRate / kTimingReferenceRate;
+	}
+
+	/** x += (target - x) * coefficient per sample, reaching 1 - 1/e of a step in ms */
+	inline double onePoleCoefficient(double ms, double sampleRate)
+	{
+		return 1.0 - exp(-1.0 / msToSamples(ms, sampleRate));
+	}
+
+	/** The time constant of such a coefficient, in ms */
+	inline double onePoleMs(double coefficient, double sampleRate)
+	{
+		return -1000.0 / (sampleRate * log(1.0 - coefficient));
+	}
+
+	/** The coefficient with the time constant at sampleRate that coefficient
+	    has at the reference rate, itself there */
+	inline double rescaleOnePole(double coefficient, double sampleRate)
+	{
+		if (sampleRate == kTimingReferenceRate) return coefficient;
+		return onePoleCoefficient(onePoleMs(coefficient, kTimingReferenceRate), sampleRate);
+	}
+
+	//------------------------------------------------------------------------
+} // namespace yg331